@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "game.hpp"
+#include "mapped_file.hpp"
+
+// Game result, as stored in archives
+#define RESULT_UNKNOWN    0
+#define RESULT_WHITE_WINS 1
+#define RESULT_BLACK_WINS 2
+#define RESULT_DRAW       3
+
+// Binary archive of games, read in place from a memory map. Native
+// little endian layout, each section 8 byte aligned:
+//   | header | moves | index | start positions |
+//   - moves: 'PackedMove' of every game, back to back
+//   - index: one 'ArchiveEntry' per game
+//   - start positions: 'ArchiveStart' of games not starting from
+//     the standard position, sorted by game
+
+namespace lc {
+    struct ArchiveHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t game_count;
+        uint64_t move_count;
+        uint64_t start_count;
+        // Section offsets in bytes
+        uint64_t moves_offset;
+        uint64_t index_offset;
+        uint64_t starts_offset;
+    };
+    static_assert(sizeof(ArchiveHeader) == 64);
+
+    // Archive entries flags
+    constexpr uint8_t ARCHIVE_CUSTOM_START = 0b1;
+
+    struct ArchiveEntry {
+        // In moves, from the start of the moves section
+        uint64_t first_move;
+        uint32_t move_count;
+        uint8_t  result;
+        uint8_t  flags;
+        uint16_t reserved;
+    };
+    static_assert(sizeof(ArchiveEntry) == 16);
+
+    struct ArchiveStart {
+        uint64_t   game;
+        BoardState board_state;
+    };
+
+    // Game view into a mapped archive, valid while it stays open
+    struct ArchiveGame {
+        std::span<const PackedMove> moves;
+        uint8_t                     result;
+        // nullptr for the standard starting position
+        const BoardState*           start;
+    };
+
+    // Writes games as they are added, only the index is kept in
+    // memory until 'close'
+    class ArchiveWriter {
+        private:
+        std::ofstream             file;
+        std::vector<ArchiveEntry> entries;
+        std::vector<ArchiveStart> starts;
+        uint64_t                  move_count;
+
+        public:
+        ArchiveWriter();
+        // Check 'is_open' for failure
+        explicit ArchiveWriter(const std::string& path);
+        // Closes the archive if still open
+        ~ArchiveWriter();
+        ArchiveWriter(const ArchiveWriter&) = delete;
+        ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+        bool open(const std::string& path);
+        bool is_open() const { return file.is_open(); }
+
+        // Moves must be legal from 'start', nullptr for the standard
+        // starting position. False for null moves or a 'start' failing
+        // 'is_valid_state', nothing is written then
+        bool add_game(
+            std::span<const PackedMove> moves,
+            uint8_t result,
+            const BoardState* start = nullptr);
+        // Game history from its starting position
+        bool add_game(const ChessGame& game, uint8_t result);
+
+        // Writes the index and header, false if anything failed to
+        // be written
+        bool close();
+    };
+
+    // Zero copy reader, games and moves point into the mapped file
+    class ArchiveReader {
+        private:
+        MappedFile          file;
+        const ArchiveEntry* entries;
+        const PackedMove*   moves;
+        const ArchiveStart* starts;
+        size_t              game_count;
+        size_t              move_count;
+        size_t              start_count;
+
+        public:
+        ArchiveReader();
+        // Check 'is_open' for failure
+        explicit ArchiveReader(const std::string& path);
+
+        // False if the file can't be mapped or isn't a valid archive
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const { return file.is_open(); }
+
+        size_t size() const { return game_count; }
+        ArchiveGame operator[](size_t game) const;
+
+        class Iterator {
+            private:
+            const ArchiveReader* reader;
+            size_t               game;
+
+            public:
+            Iterator(const ArchiveReader* _reader, size_t _game)
+                : reader(_reader), game(_game) {}
+            ArchiveGame operator*() const { return (*reader)[game]; }
+            Iterator& operator++() { ++game; return *this; }
+            bool operator==(const Iterator& other) const { return game == other.game; }
+            bool operator!=(const Iterator& other) const { return game != other.game; }
+        };
+
+        Iterator begin() const { return { this, 0 }; }
+        Iterator end() const { return { this, game_count }; }
+    };
+
+    // Archives are untrusted: start positions go through
+    // 'is_valid_state' and each move is checked to be legal
+
+    // Game at its starting position, std::nullopt if it isn't valid
+    std::optional<ChessGame> start_game(const ArchiveGame&);
+    // Game after its first 'plies' moves, std::nullopt if the start
+    // position or one of these moves isn't valid
+    std::optional<ChessGame> replay(const ArchiveGame&, size_t plies = SIZE_MAX);
+    // Calls 'f(game, move)' before each move is made, 'game' is
+    // reused for every move so nothing is allocated per move. Stops
+    // at the first illegal move, false if there's one or the start
+    // position isn't valid
+    template<typename F>
+    bool replay(const ArchiveGame&, F&& f);
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc {
+    template<typename F>
+    bool replay(const ArchiveGame& archived, F&& f) {
+        auto game = start_game(archived);
+        if(!game.has_value())
+            return false;
+        game->reserve(archived.moves.size());
+        for(const auto packed : archived.moves) {
+            const auto move = find_legal_move(game->board, game->turn(),
+                game->castling_state(), game->en_passant_square(), packed);
+            if(!move.has_value())
+                return false;
+            f(static_cast<const ChessGame&>(*game), *move);
+            game->make_move(*move);
+        }
+        return true;
+    }
+}
\ No newline at end of file
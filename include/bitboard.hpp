@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <bit>
+
+// Squares are indexed as 'y*8 + x', the same byte order used by
+// 'Board::board_data', so bit 0 is a8 and bit 63 is h1
+
+namespace lc {
+    using Bitboard = uint64_t;
+    using Square = uint8_t;
+
+    constexpr Bitboard square_bb(Square sq) { return Bitboard(1) << sq; }
+    constexpr Square lsb(Bitboard bb) { return Square(std::countr_zero(bb)); }
+    constexpr int popcount(Bitboard bb) { return std::popcount(bb); }
+    // Returns least significant square and removes it from 'bb'
+    constexpr Square pop_lsb(Bitboard& bb) {
+        const auto sq = lsb(bb);
+        bb &= bb - 1;
+        return sq;
+    }
+
+    // Used for absent squares (i.e no en passant square)
+    constexpr Square NO_SQUARE = 64;
+
+    constexpr Bitboard FILE_A_BB = 0x0101010101010101;
+    constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+    constexpr Bitboard RANK_8_BB = 0xff;
+    constexpr Bitboard RANK_1_BB = RANK_8_BB << 56;
+
+    // Non sliding pieces attacks, indexed by square
+    constexpr std::array<Bitboard,64> leaper_attacks(
+        const std::array<int8_t,2> (&diffs)[8]);
+    constexpr std::array<Bitboard,64> pawn_attacks_table(int8_t direction);
+
+    constexpr std::array<int8_t,2> KNIGHT_DIFFS[8] = {
+        { 1, 2}, {-1,-2}, { 1,-2}, {-1, 2},
+        { 2, 1}, {-2,-1}, { 2,-1}, {-2, 1}
+    };
+    constexpr std::array<int8_t,2> KING_DIFFS[8] = {
+        { 1, 0}, {-1, 0}, { 0,-1}, { 0, 1},
+        { 1, 1}, {-1,-1}, { 1,-1}, {-1, 1}
+    };
+
+    inline Bitboard bishop_attacks(Square sq, Bitboard occupancy);
+    inline Bitboard rook_attacks(Square sq, Bitboard occupancy);
+    inline Bitboard queen_attacks(Square sq, Bitboard occupancy);
+
+    // Squares strictly between 'a' and 'b' if aligned, 0 otherwise
+    inline Bitboard between(Square a, Square b);
+    // Whole board line through 'a' and 'b' if aligned, 0 otherwise
+    inline Bitboard line(Square a, Square b);
+
+    // Slow ray walk, used to build the lookup tables
+    constexpr Bitboard sliding_attacks(
+        const std::array<int8_t,2> (&dirs)[4],
+        Square sq,
+        Bitboard occupancy);
+}
+
+/////////////// Implementation ///////////////
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace lc {
+    namespace detail {
+        struct Magic {
+            Bitboard        mask;
+            Bitboard        magic;
+            Bitboard*       attacks;
+            unsigned        shift;
+
+            inline unsigned index(Bitboard occupancy) const {
+            #if defined(__BMI2__)
+                return unsigned(_pext_u64(occupancy, mask));
+            #else
+                return unsigned(((occupancy & mask) * magic) >> shift);
+            #endif
+            }
+        };
+
+        extern Magic bishop_magics[64];
+        extern Magic rook_magics[64];
+        extern Bitboard between_table[64][64];
+        extern Bitboard line_table[64][64];
+
+        constexpr std::array<int8_t,2> bishop_dirs[4] = {
+            { 1,-1}, {-1,-1}, { 1, 1}, {-1, 1}
+        };
+        constexpr std::array<int8_t,2> rook_dirs[4] = {
+            { 0,-1}, { 0, 1}, { 1, 0}, {-1, 0}
+        };
+    }
+
+    constexpr std::array<Bitboard,64> leaper_attacks(
+        const std::array<int8_t,2> (&diffs)[8])
+    {
+        std::array<Bitboard,64> table = {};
+        for(int8_t sq = 0; sq < 64; ++sq) {
+            for(const auto& diff : diffs) {
+                const int8_t x = sq % 8 + diff[0];
+                const int8_t y = sq / 8 + diff[1];
+                if(x >= 0 && x <= 7 && y >= 0 && y <= 7)
+                    table[sq] |= square_bb(Square(y*8 + x));
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<Bitboard,64> pawn_attacks_table(int8_t direction) {
+        std::array<Bitboard,64> table = {};
+        for(int8_t sq = 0; sq < 64; ++sq) {
+            const int8_t y = sq / 8 + direction;
+            if(y < 0 || y > 7)
+                continue;
+            for(int8_t x : { int8_t(sq % 8 - 1), int8_t(sq % 8 + 1) })
+                if(x >= 0 && x <= 7)
+                    table[sq] |= square_bb(Square(y*8 + x));
+        }
+        return table;
+    }
+
+    inline constexpr auto knight_attacks = leaper_attacks(KNIGHT_DIFFS);
+    inline constexpr auto king_attacks = leaper_attacks(KING_DIFFS);
+    // Pawn attacks, indexed by color index (color >> 3) and square
+    inline constexpr std::array<std::array<Bitboard,64>,2> pawn_attacks = {
+        pawn_attacks_table(-1),
+        pawn_attacks_table(1)
+    };
+
+    constexpr Bitboard sliding_attacks(
+        const std::array<int8_t,2> (&dirs)[4],
+        Square sq,
+        Bitboard occupancy)
+    {
+        Bitboard attacks = 0;
+        for(const auto& dir : dirs) {
+            int8_t x = sq % 8;
+            int8_t y = sq / 8;
+            while(true) {
+                x += dir[0];
+                y += dir[1];
+                if(x < 0 || x > 7 || y < 0 || y > 7)
+                    break;
+                const auto bb = square_bb(Square(y*8 + x));
+                attacks |= bb;
+                if(occupancy & bb)
+                    break;
+            }
+        }
+        return attacks;
+    }
+
+    inline Bitboard bishop_attacks(Square sq, Bitboard occupancy) {
+        const auto& m = detail::bishop_magics[sq];
+        return m.attacks[m.index(occupancy)];
+    }
+
+    inline Bitboard rook_attacks(Square sq, Bitboard occupancy) {
+        const auto& m = detail::rook_magics[sq];
+        return m.attacks[m.index(occupancy)];
+    }
+
+    inline Bitboard queen_attacks(Square sq, Bitboard occupancy) {
+        return bishop_attacks(sq, occupancy) | rook_attacks(sq, occupancy);
+    }
+
+    inline Bitboard between(Square a, Square b) {
+        return detail::between_table[a][b];
+    }
+
+    inline Bitboard line(Square a, Square b) {
+        return detail::line_table[a][b];
+    }
+}
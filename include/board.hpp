@@ -1,40 +1,83 @@
 #pragma once
 
 #include "piece.hpp"
+#include "bitboard.hpp"
+#include "swar.hpp"
+#include "kogge_stone.hpp"
 
 #include <array>
 #include <cassert>
+#include <cstddef>
 
 namespace lc {
     using Position = std::array<uint8_t,2>;
 
+    constexpr Square square_of(const Position& pos) { return Square(pos[1]*8 + pos[0]); }
+    constexpr Position position_of(Square sq) { return { uint8_t(sq % 8), uint8_t(sq / 8) }; }
+    // Index in per color tables, WHITE -> 0 and BLACK -> 1
+    constexpr uint8_t color_index(Color c) { return c >> 3; }
+
     class Board {
         public:
         std::array<uint64_t,8> board_data;
+        // Bitboards mirror 'board_data' and are kept in sync by 'set'.
+        // 'kind_bb[NONE]' holds the empty squares
+        std::array<Bitboard,8> kind_bb;
+        std::array<Bitboard,2> color_bb;
         
         public:
-        constexpr Board(const std::array<uint64_t,8>& data)
-            : board_data{data} {}
+        constexpr Board(const std::array<uint64_t,8>& data);
         static constexpr Board standard();
         static constexpr Board empty();
 
         constexpr Piece at(const Position&) const;
+        constexpr Piece at(Square) const;
         constexpr void set(const Position&, const Piece&);
 
-        constexpr bool operator==(const Board& other) {
-            for(size_t i = 0; i < 8; ++i)
-                if(board_data[i] != other.board_data[i])
-                    return false;
-            return true;
+        constexpr Bitboard occupancy() const { return color_bb[0] | color_bb[1]; }
+        constexpr Bitboard pieces(Color c) const { return color_bb[color_index(c)]; }
+        constexpr Bitboard pieces(Color c, uint8_t kind) const {
+            return color_bb[color_index(c)] & kind_bb[kind];
+        }
+        // Pieces of both colors attacking 'sq' given 'occupancy'
+        inline Bitboard attackers_to(Square sq, Bitboard occupancy) const;
+        // Every square attacked by pieces of color 'c'
+        inline Bitboard attacks(Color c) const;
+        inline bool is_attacked(Square sq, Color by) const {
+            return attackers_to(sq, occupancy()) & pieces(by);
+        }
+
+        constexpr bool operator==(const Board& other) const {
+            return swar::equal(board_data, other.board_data);
+        }
+        // Squares holding different pieces
+        constexpr Bitboard diff(const Board& other) const {
+            return swar::diff(board_data, other.board_data);
+        }
+        constexpr int count(const Piece& piece) const {
+            return swar::count(board_data, piece);
         }
     };
 }
 
 /////////////// Implementation ///////////////
 
-#include <fmt/core.h>
-
 namespace lc {
+    constexpr Board::Board(const std::array<uint64_t,8>& data)
+        : board_data{data}
+        , kind_bb{}
+        , color_bb{}
+    {
+        // Bitboards are built a row at a time
+        for(size_t y = 0; y < 8; ++y) {
+            const auto row = board_data[y];
+            for(uint8_t kind = NONE; kind <= KING; ++kind)
+                kind_bb[kind] |= Bitboard(swar::kind_mask(row, kind)) << (y*8);
+            for(Color color : { WHITE, BLACK })
+                color_bb[color_index(color)] |= Bitboard(swar::color_mask(row, color)) << (y*8);
+        }
+    }
+
     constexpr Board Board::standard() {
         constexpr std::array<uint64_t,8> data = {
             0x0c0a0b0e0d0b0a0c,
@@ -68,10 +111,24 @@ namespace lc {
         assert(pos[0] < 8 && pos[1] < 8);
         return Piece((board_data[pos[1]] >> (pos[0]*8)) & 0xff);
     }
+
+    constexpr Piece Board::at(Square sq) const {
+        assert(sq < 64);
+        return Piece((board_data[sq / 8] >> (sq % 8 * 8)) & 0xff);
+    }
     
     constexpr void Board::set(const Position& pos, const Piece& piece) {
         // TODO: Bounds check error handling
         assert(pos[0] < 8 && pos[1] < 8);
+        const auto bb = square_bb(square_of(pos));
+        const auto old_piece = at(pos);
+        kind_bb[old_piece.kind()] &= ~bb;
+        if(old_piece.kind() != NONE)
+            color_bb[color_index(old_piece.color())] &= ~bb;
+        kind_bb[piece.kind()] |= bb;
+        if(piece.kind() != NONE)
+            color_bb[color_index(piece.color())] |= bb;
+
         // Impl 1: Faster
         uint64_t mask = ~(uint64_t(0xff) << (pos[0]*8));
         board_data[pos[1]] &= mask;
@@ -82,4 +139,43 @@ namespace lc {
         // board_data[pos[1]] -= sub;
         // board_data[pos[1]] += (piece.raw() << (pos[0]*8));
     }
-}
\ No newline at end of file
+
+    inline Bitboard Board::attackers_to(Square sq, Bitboard occupancy) const {
+        const auto diagonal = kind_bb[BISHOP] | kind_bb[QUEEN];
+        const auto straight = kind_bb[ROOK] | kind_bb[QUEEN];
+        return (pawn_attacks[color_index(WHITE)][sq] & pieces(BLACK, PAWN))
+            | (pawn_attacks[color_index(BLACK)][sq] & pieces(WHITE, PAWN))
+            | (knight_attacks[sq] & kind_bb[KNIGHT])
+            | (king_attacks[sq] & kind_bb[KING])
+            | (bishop_attacks(sq, occupancy) & diagonal)
+            | (rook_attacks(sq, occupancy) & straight);
+    }
+
+    inline Bitboard Board::attacks(Color c) const {
+        const auto occupancy_bb = occupancy();
+        // Pawns a whole set at a time, white ones attack towards rank 8
+        const auto pawns = pieces(c, PAWN);
+        Bitboard attacked = c == WHITE
+            ? ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7)
+            : ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9);
+
+        auto knights = pieces(c, KNIGHT);
+        while(knights)
+            attacked |= knight_attacks[pop_lsb(knights)];
+        auto diagonal = pieces(c) & (kind_bb[BISHOP] | kind_bb[QUEEN]);
+        auto straight = pieces(c) & (kind_bb[ROOK] | kind_bb[QUEEN]);
+        // Only the AVX2 fills beat a magic lookup per slider
+        if(kogge_stone::backend() == kogge_stone::Backend::AVX2)
+            attacked |= kogge_stone::slider_attacks(diagonal, straight, occupancy_bb);
+        else {
+            while(diagonal)
+                attacked |= bishop_attacks(pop_lsb(diagonal), occupancy_bb);
+            while(straight)
+                attacked |= rook_attacks(pop_lsb(straight), occupancy_bb);
+        }
+        auto kings = pieces(c, KING);
+        while(kings)
+            attacked |= king_attacks[pop_lsb(kings)];
+        return attacked;
+    }
+}
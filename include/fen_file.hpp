@@ -0,0 +1,24 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "game.hpp"
+
+namespace lc {
+    struct FenBatch {
+        // In file order, invalid lines are left out
+        std::vector<BoardState> positions;
+        // Non empty lines that failed to parse
+        size_t                  invalid_lines = 0;
+    };
+
+    // Parses one FEN per line across 'threads' threads (0 for one
+    // per hardware thread). Lines may end with "\r\n"
+    FenBatch parse_fen_lines(std::string_view text, unsigned threads = 0);
+    // Same as 'parse_fen_lines' over a memory mapped file,
+    // std::nullopt if the file can't be opened
+    std::optional<FenBatch> load_fen_file(const std::string& path, unsigned threads = 0);
+}
\ No newline at end of file
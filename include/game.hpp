@@ -3,31 +3,158 @@
 #include <vector>
 #include <utility>
 
-#include "move.hpp"
+#include "evaluation.hpp"
+#include "move_list.hpp"
+#include "packed_move.hpp"
+#include "piece_moves.hpp"
 
 // Extends bits from piece_moves.hpp
 #define TURN_COLOR_BIT 0b1000000
 
 namespace lc {
+    // Information lost when a move is applied, kept per ply to undo it
+    struct UndoRecord {
+        Piece       captured;
+        uint8_t     state;
+        Square      en_passant;
+        uint16_t    halfmove_clock;
+        eval::Score psq;
+        uint64_t    hash;
+    };
+
+    // Position with its game state but no history, compact enough
+    // to be kept in large arrays (i.e loaded from FEN files)
+    struct BoardState {
+        std::array<uint64_t,8> board_data;
+        uint8_t                state;
+        Square                 en_passant;
+        // Plies since the last capture or pawn move
+        uint16_t               halfmove_clock;
+        // Starts at 1, incremented after each black move
+        uint16_t               fullmove_number;
+    };
+
+    enum class GameStatus : uint8_t {
+        Ongoing,
+        Checkmate,
+        Stalemate,
+        // Draws
+        FiftyMoveRule,
+        ThreefoldRepetition,
+        InsufficientMaterial
+    };
+
     class ChessGame {   
         private:
         // Game state (turn color, ...)
-        bool              free_game;
-        uint8_t           state;
-        std::vector<Move> move_history;
+        bool                    free_game;
+        uint8_t                 state;
+        // Square skipped by a pawn double move in the last turn
+        Square                  en_passant;
+        // Zobrist hash, updated incrementally by 'make_move'
+        uint64_t                hash_key;
+        uint16_t                halfmove_clock;
+        // Plies since the start of the game, including the moves
+        // before the game was resumed
+        uint16_t                game_ply;
+        // Material and piece-square score from white point of view,
+        // updated incrementally by 'make_move'
+        eval::Score             psq;
+        std::vector<PackedMove> move_history;
+        // Parallel to 'move_history'
+        std::vector<UndoRecord> undo_history;
+        // Attack maps and checkers of the current position, computed
+        // on first use and dropped by every move or undo. Direct edits
+        // of 'board' are not tracked. Const queries fill them, so a
+        // game shared between threads must not be queried concurrently
+        mutable Bitboard        attacked_cache[2];
+        mutable Bitboard        checkers_cache;
+        mutable uint8_t         cached;
 
         public:
-        Board             board;
+        Board                   board;
 
         public:
         explicit ChessGame(const Board& _board, bool _free_game = false);
         explicit ChessGame(Board&& _board, bool _free_game = false);
+        // Game resumed from a given state (i.e loaded from FEN)
+        explicit ChessGame(const BoardState& _board_state, bool _free_game = false);
         
-        bool move(const Position&, const Position&);
-        // TODO:
+        // Moves a piece of the side to move within its legal moveset,
+        // MoveError::None if the move was made. Promotions are to a
+        // queen
+        MoveError move(const Position&, const Position&);
+        // Applies a move without validating it, 'move' must come
+        // from 'legal_moves'
+        void make_move(const Move&);
+        // Passes the turn, used by search. Undone by 'undo' as well
+        void make_null_move();
+        // Reverts the last move, false if there's none
         bool undo();
+        // Preallocates history for 'plies' more moves, so making
+        // moves doesn't allocate
+        void reserve(size_t plies);
 
-        std::vector<Move> piece_moveset(const Position&) const;
+        // Position identity: pieces, turn, castling rights and en passant
+        uint64_t hash() const { return hash_key; }
+        // Color of the pieces to move
+        Color turn() const { return (state & TURN_COLOR_BIT) ? BLACK : WHITE; }
+        // King and rooks moved bits, see piece_moves.hpp
+        uint8_t castling_state() const { return state & CASTLING_STATE_MASK; }
+        // Only set when an en passant capture is possible
+        Square en_passant_square() const { return en_passant; }
+        uint16_t halfmove() const { return halfmove_clock; }
+        uint16_t fullmove_number() const { return uint16_t(game_ply / 2 + 1); }
+        BoardState board_state() const;
+        // Moves made since the game was created, null moves included
+        const std::vector<PackedMove>& history() const { return move_history; }
+        // Static evaluation in centipawns, from the side to move
+        // point of view
+        int evaluate() const;
 
+        // Legal moves of the piece on a square, of either color
+        MoveList piece_moveset(const Position&) const;
+        void piece_moveset(const Position&, MoveList&) const;
+        // Every legal move of the side to move, none if it has no
+        // king (free board setups)
+        MoveList legal_moves() const;
+        void legal_moves(MoveList&) const;
+
+        // Checkmate and stalemate take precedence over the draw rules,
+        // a side to move without king is stalemated. Cost doesn't grow
+        // with the game length: one move generation and at most 50
+        // hash comparisons
+        GameStatus status() const;
+        bool is_game_over() const { return status() != GameStatus::Ongoing; }
+        // Earlier occurrences of the current position, only looking
+        // back to the last capture, pawn move or null move since no
+        // position before it can repeat
+        int repetitions() const;
+        bool is_fifty_move_rule() const { return halfmove_clock >= 100; }
+        // Neither side can mate: lone kings, a single minor piece or
+        // only bishops on squares of the same color
+        bool is_insufficient_material() const;
+
+        // Squares attacked by pieces of color 'by'
+        Bitboard attacked_squares(Color by) const;
+        bool is_square_attacked(const Position&, Color by) const;
+        // Pieces giving check to the side to move
+        Bitboard checkers() const;
+        bool is_check() const { return checkers() != 0; }
+
+        private:
+        uint64_t compute_hash() const;
     };
+
+    // False for positions move generation can't handle: unknown piece
+    // bytes, not exactly one king per color, pawns on the first or
+    // last rank, the side not to move in check, castling rights without
+    // the king and rook on their squares or an en passant square no
+    // pawn double move could have skipped
+    bool is_valid_state(const BoardState&);
+
+    // Board, castling state and en passant square update of
+    // 'make_move', without turn, clocks, hash or history. For callers
+    // keeping positions more compactly than a 'ChessGame'
+    void apply_board_move(Board&, const Move&, uint8_t& state, Square& en_passant);
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "game.hpp"
+#include "thread_pool.hpp"
+
+namespace lc {
+    // Handle of a game in a 'GameStore'. Slots are reused after a game
+    // is erased, the generation tells stale handles apart
+    struct GameId {
+        uint32_t slot;
+        uint32_t generation;
+
+        constexpr bool operator==(const GameId& other) const {
+            return slot == other.slot && generation == other.generation;
+        }
+        constexpr bool operator!=(const GameId& other) const { return !(*this == other); }
+    };
+    // Never a live game, its generation is even
+    constexpr GameId INVALID_GAME_ID = { UINT32_MAX, 0 };
+
+    struct GameMove {
+        GameId     game;
+        PackedMove move;
+    };
+
+    // Many live games kept compactly, about 100 bytes per game plus
+    // 64 bytes every 30 moves, against a kilobyte or more for a
+    // 'ChessGame'. Games are stored as parallel arrays indexed by slot
+    // and their move histories as linked chunks from a shared pool.
+    // Only the position is kept: there are no undo records, hash or
+    // evaluation. Not thread safe, but 'apply_moves' is parallel
+    class GameStore {
+        private:
+        static constexpr uint32_t NO_CHUNK = UINT32_MAX;
+        static constexpr size_t   CHUNK_MOVES = 30;
+
+        // One cache line of history
+        struct alignas(64) HistoryChunk {
+            PackedMove moves[CHUNK_MOVES];
+            uint32_t   next;
+        };
+        static_assert(sizeof(HistoryChunk) == 64);
+
+        // Chunks are allocated in blocks that never move, so workers
+        // can append to their games while others allocate
+        class ChunkPool {
+            private:
+            static constexpr size_t BLOCK_CHUNKS = 4096;
+            static constexpr size_t MAX_BLOCKS = 1 << 16;
+
+            std::unique_ptr<std::unique_ptr<HistoryChunk[]>[]> blocks;
+            size_t                block_count;
+            uint32_t              chunk_count;
+            std::vector<uint32_t> free_chunks;
+            std::mutex            mutex;
+
+            public:
+            ChunkPool();
+
+            HistoryChunk& operator[](uint32_t chunk) {
+                return blocks[chunk / BLOCK_CHUNKS][chunk % BLOCK_CHUNKS];
+            }
+            const HistoryChunk& operator[](uint32_t chunk) const {
+                return blocks[chunk / BLOCK_CHUNKS][chunk % BLOCK_CHUNKS];
+            }
+            // Thread safe
+            uint32_t allocate();
+            // Frees a whole chain
+            void release(uint32_t first);
+            size_t memory_usage() const;
+        };
+
+        // Per slot
+        std::vector<std::array<uint64_t,8>> boards;
+        std::vector<uint8_t>                states;
+        std::vector<Square>                 en_passants;
+        std::vector<uint16_t>               halfmove_clocks;
+        std::vector<uint16_t>               fullmove_numbers;
+        std::vector<uint32_t>               move_counts;
+        std::vector<uint32_t>               first_chunks;
+        std::vector<uint32_t>               last_chunks;
+        // Odd while the slot holds a game
+        std::vector<uint32_t>               generations;
+
+        std::vector<uint32_t>               free_slots;
+        size_t                              game_count;
+        ChunkPool                           chunks;
+        // Games not starting from the standard position, by slot
+        std::unordered_map<uint32_t,BoardState> custom_starts;
+        ThreadPool                          pool;
+
+        public:
+        // 'threads' validating batches, 0 for one per hardware thread
+        explicit GameStore(unsigned threads = 0);
+
+        // New game from the standard starting position
+        GameId create();
+        // 'INVALID_GAME_ID' if 'start' fails 'is_valid_state'
+        GameId create(const BoardState& start);
+        bool erase(GameId);
+        bool contains(GameId) const;
+        size_t size() const { return game_count; }
+        void reserve(size_t games);
+
+        // std::nullopt for unknown games
+        std::optional<BoardState> board_state(GameId) const;
+        // Moves made so far, oldest first
+        std::optional<std::vector<PackedMove>> history(GameId) const;
+        // Full game replayed from its start, undo included
+        std::optional<ChessGame> game(GameId) const;
+
+        // Validates the move against the legal moves of the game and
+        // makes it, MoveError::None on success
+        MoveError apply_move(const GameMove&);
+        // Same as 'apply_move' for every entry, spread over the thread
+        // pool. Moves of the same game are made in their batch order.
+        // 'results' must be as long as 'moves'
+        void apply_moves(std::span<const GameMove> moves, std::span<MoveError> results);
+        std::vector<MoveError> apply_moves(std::span<const GameMove> moves);
+
+        // Bytes held by the store, slots and chunks
+        size_t memory_usage() const;
+
+        private:
+        bool valid(GameId id) const {
+            return id.slot < generations.size()
+                && generations[id.slot] == id.generation
+                && (id.generation & 1);
+        }
+        void push_history(uint32_t slot, PackedMove move);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "bitboard.hpp"
+
+// Set-wise sliding attacks with Kogge-Stone occluded fills: every
+// slider of a set is flooded at once along each direction, instead of
+// a magic lookup per piece. SIMD backends are chosen at runtime from
+// the CPU features, so a single binary runs anywhere
+
+namespace lc::kogge_stone {
+    enum class Backend : uint8_t {
+        Scalar,
+        // Directions in pairs of 64 bit lanes
+        SSE2,
+        // All eight directions in two registers, four queries per
+        // register in batches
+        AVX2
+    };
+
+    struct SliderQuery {
+        // Bishops and queens
+        Bitboard diagonal;
+        // Rooks and queens
+        Bitboard straight;
+        Bitboard occupancy;
+    };
+
+    // Widest backend the CPU supports, unless set otherwise
+    Backend backend();
+    // False if the CPU doesn't support it. Meant for benchmarks and
+    // checks, not to be called while other threads use this
+    bool set_backend(Backend);
+    const char* backend_name(Backend);
+
+    // Squares attacked by every slider of the sets
+    Bitboard slider_attacks(Bitboard diagonal, Bitboard straight, Bitboard occupancy);
+    // 'out[i]' gets the attacks of 'queries[i]', 'out' must be as
+    // long as 'queries'. Queries can be whole positions or single
+    // pieces
+    void slider_attacks(std::span<const SliderQuery> queries, std::span<Bitboard> out);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lc {
+    // Read only view of a whole file, memory mapped when the system
+    // supports it, read into memory otherwise
+    class MappedFile {
+        private:
+        const char*       begin;
+        size_t            length;
+        bool              mapped;
+        // Fallback storage when the file can't be mapped
+        std::vector<char> buffer;
+
+        public:
+        MappedFile();
+        // Check 'is_open' for failure
+        explicit MappedFile(const std::string& path);
+        MappedFile(MappedFile&&) noexcept;
+        MappedFile& operator=(MappedFile&&) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        // False if the file can't be opened or read
+        bool open(const std::string& path);
+        void close();
+
+        bool is_open() const { return begin != nullptr; }
+        const char* data() const { return begin; }
+        size_t size() const { return length; }
+        std::string_view view() const { return { begin, length }; }
+    };
+}
\ No newline at end of file
@@ -10,6 +10,20 @@ template<class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
 template<class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
 
 namespace lc {
+    // Why 'ChessGame::move' rejected a move
+    enum class MoveError : uint8_t {
+        None,
+        // Piece of the side not to move
+        NotYourTurn,
+        // No piece on the starting square
+        NoPiece,
+        // Not in the piece moveset
+        InvalidMove,
+        // Game id not in a 'GameStore'
+        UnknownGame
+    };
+    constexpr size_t MOVE_ERROR_COUNT = 5;
+
     class Move {
         public:
         // Can capture
@@ -52,6 +66,8 @@ namespace lc {
         constexpr Position to() const { return to_pos; }
         template<typename ...F>
         constexpr void visit(F&&...);
+        template<typename ...F>
+        constexpr void visit(F&&...) const;
 
         private:
         constexpr Move(Position&& _from, Position&& _to, MoveKind&& _kind)
@@ -137,4 +153,9 @@ namespace lc {
     constexpr void Move::visit(F&&... visitors) {
         std::visit(overloaded{ std::forward<F>(visitors)... }, kind);
     }
+
+    template<typename ...F>
+    constexpr void Move::visit(F&&... visitors) const {
+        std::visit(overloaded{ std::forward<F>(visitors)... }, kind);
+    }
 }
\ No newline at end of file
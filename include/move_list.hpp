@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <new>
+#include <memory>
+
+#include "move.hpp"
+
+namespace lc {
+    // Stack allocated list of moves with fixed capacity, enough
+    // for the moves of any legal position
+    class MoveList {
+        public:
+        using value_type = Move;
+        using iterator = Move*;
+        using const_iterator = const Move*;
+        static constexpr size_t CAPACITY = 256;
+
+        private:
+        // Left uninitialized, moves are constructed on insertion
+        alignas(Move) unsigned char storage[CAPACITY * sizeof(Move)];
+        size_t count;
+
+        public:
+        MoveList()
+            : count(0) {}
+        MoveList(const MoveList&);
+        MoveList& operator=(const MoveList&);
+
+        void push_back(const Move&);
+        template<typename ...Args>
+        Move& emplace_back(Args&&...);
+        void pop_back() { --count; }
+        void clear() { count = 0; }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        Move* data() { return std::launder(reinterpret_cast<Move*>(storage)); }
+        const Move* data() const { return std::launder(reinterpret_cast<const Move*>(storage)); }
+
+        Move& operator[](size_t i) { return data()[i]; }
+        const Move& operator[](size_t i) const { return data()[i]; }
+        Move& back() { return data()[count - 1]; }
+        const Move& back() const { return data()[count - 1]; }
+
+        iterator begin() { return data(); }
+        iterator end() { return data() + count; }
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + count; }
+    };
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc {
+    inline MoveList::MoveList(const MoveList& other)
+        : count(other.count)
+    {
+        std::uninitialized_copy(other.begin(), other.end(), data());
+    }
+
+    inline MoveList& MoveList::operator=(const MoveList& other) {
+        count = other.count;
+        std::uninitialized_copy(other.begin(), other.end(), data());
+        return *this;
+    }
+
+    inline void MoveList::push_back(const Move& move) {
+        assert(count < CAPACITY);
+        std::construct_at(data() + count, move);
+        ++count;
+    }
+
+    template<typename ...Args>
+    inline Move& MoveList::emplace_back(Args&&... args) {
+        assert(count < CAPACITY);
+        auto* move = std::construct_at(data() + count, std::forward<Args>(args)...);
+        ++count;
+        return *move;
+    }
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include "game.hpp"
+#include "see.hpp"
+
+namespace lc {
+    // Quiet moves that caused a beta cutoff at the same ply, newest first
+    using Killers = std::array<PackedMove,2>;
+
+    // Quiet move scores by color, from and to square. Raised by moves
+    // causing beta cutoffs and lowered by the ones tried before them
+    class HistoryTable {
+        public:
+        // Scores saturate towards this bound
+        static constexpr int MAX_SCORE = 16384;
+
+        private:
+        int16_t scores[2][64][64];
+
+        public:
+        HistoryTable() { clear(); }
+
+        void clear();
+        int get(Color us, PackedMove move) const {
+            return scores[color_index(us)][move.from_square()][move.to_square()];
+        }
+        // 'bonus' is negative for moves that didn't cut off
+        void update(Color us, PackedMove move, int bonus);
+    };
+
+    // Yields the legal moves of a position in stages, each generated
+    // only once the previous ones are exhausted: hash move, captures
+    // by MVV-LVA that don't lose material, killers, quiet moves by
+    // history, then losing captures. Most nodes cut off within the
+    // first stages, before quiet moves are generated. The game must be
+    // in the same position on every call to 'next'
+    class MovePicker {
+        private:
+        enum class Stage : uint8_t {
+            HashMove,
+            GenerateCaptures,
+            GoodCaptures,
+            KillerMoves,
+            GenerateQuiets,
+            Quiets,
+            BadCaptures,
+            Done
+        };
+
+        const ChessGame&    game;
+        const HistoryTable& history;
+        PackedMove          hash_move;
+        Killers             killers;
+        Stage               stage;
+        // Stops after the good captures
+        bool                captures_only;
+        uint8_t             killer_index;
+        // Captures then quiet moves, with their scores. The ones
+        // before 'current' were already yielded, or moved to the
+        // losing captures at the start of the list
+        MoveList            moves;
+        int                 scores[MoveList::CAPACITY];
+        size_t              current;
+        size_t              bad_captures_end;
+
+        public:
+        MovePicker(
+            const ChessGame& _game,
+            PackedMove _hash_move,
+            const Killers& _killers,
+            const HistoryTable& _history);
+        // Only the captures that don't lose material, for quiescence
+        MovePicker(const ChessGame& _game, const HistoryTable& _history);
+
+        // Next move to search, false once every move was yielded
+        bool next(Move& move);
+
+        private:
+        // Highest scoring move left in the stage, skipping the moves
+        // of earlier stages
+        bool select(Move& move);
+        void generate(MoveGen gen);
+    };
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc {
+    inline void HistoryTable::clear() {
+        std::fill_n(&scores[0][0][0], 2 * 64 * 64, int16_t(0));
+    }
+
+    inline void HistoryTable::update(Color us, PackedMove move, int bonus) {
+        auto& score = scores[color_index(us)][move.from_square()][move.to_square()];
+        bonus = std::clamp(bonus, -MAX_SCORE, MAX_SCORE);
+        // Scores close to the bound move less, so old cutoffs fade
+        score += int16_t(bonus - score * std::abs(bonus) / MAX_SCORE);
+    }
+
+    inline MovePicker::MovePicker(
+        const ChessGame& _game,
+        PackedMove _hash_move,
+        const Killers& _killers,
+        const HistoryTable& _history)
+        : game(_game)
+        , history(_history)
+        , hash_move(_hash_move)
+        , killers(_killers)
+        , stage(Stage::HashMove)
+        , captures_only(false)
+        , killer_index(0)
+        , current(0)
+        , bad_captures_end(0) {}
+
+    inline MovePicker::MovePicker(const ChessGame& _game, const HistoryTable& _history)
+        : game(_game)
+        , history(_history)
+        , hash_move(PackedMove::none())
+        , killers{}
+        , stage(Stage::GenerateCaptures)
+        , captures_only(true)
+        , killer_index(0)
+        , current(0)
+        , bad_captures_end(0) {}
+
+    inline void MovePicker::generate(MoveGen gen) {
+        // Appended, losing captures are kept for the last stage
+        current = moves.size();
+        generate_legal_moves(game.board, game.turn(), game.castling_state(),
+            game.en_passant_square(), moves, gen);
+        for(size_t i = current; i < moves.size(); ++i) {
+            const auto packed = PackedMove(moves[i]);
+            if(gen == MoveGen::Quiets) {
+                scores[i] = history.get(game.turn(), packed);
+                continue;
+            }
+            const auto victim = packed.is_en_passant()
+                ? PAWN
+                : game.board.at(packed.to_square()).kind();
+            const auto attacker = game.board.at(packed.from_square()).kind();
+            scores[i] = PIECE_VALUES[victim] * 8 - attacker;
+            // Queen promotions gain a queen, underpromotions go last
+            if(packed.is_promotion())
+                scores[i] += packed.promotion_kind() == QUEEN
+                    ? PIECE_VALUES[QUEEN] * 8
+                    : -PIECE_VALUES[QUEEN] * 8;
+        }
+    }
+
+    inline bool MovePicker::select(Move& move) {
+        while(current < moves.size()) {
+            // Selection sort, most nodes cut off before the list ends
+            size_t best = current;
+            for(size_t i = current + 1; i < moves.size(); ++i)
+                if(scores[i] > scores[best])
+                    best = i;
+            std::swap(moves[current], moves[best]);
+            std::swap(scores[current], scores[best]);
+
+            const auto packed = PackedMove(moves[current]);
+            move = moves[current++];
+            if(packed == hash_move)
+                continue;
+            if(stage == Stage::Quiets && (packed == killers[0] || packed == killers[1]))
+                continue;
+            return true;
+        }
+        return false;
+    }
+
+    inline bool MovePicker::next(Move& move) {
+        const auto us = game.turn();
+        switch(stage) {
+            case Stage::HashMove: {
+                stage = Stage::GenerateCaptures;
+                if(!hash_move.is_none()) {
+                    const auto legal = find_legal_move(game.board, us, game.castling_state(),
+                        game.en_passant_square(), hash_move);
+                    if(legal.has_value()) {
+                        move = *legal;
+                        return true;
+                    }
+                }
+                [[fallthrough]];
+            }
+            case Stage::GenerateCaptures: {
+                generate(MoveGen::Captures);
+                stage = Stage::GoodCaptures;
+                [[fallthrough]];
+            }
+            case Stage::GoodCaptures: {
+                while(select(move)) {
+                    // Exchanges are only resolved for the captures
+                    // reached, losing ones are searched last
+                    if(see(game.board, move) < 0) {
+                        moves[bad_captures_end++] = move;
+                        continue;
+                    }
+                    return true;
+                }
+                if(captures_only) {
+                    stage = Stage::Done;
+                    return false;
+                }
+                stage = Stage::KillerMoves;
+                [[fallthrough]];
+            }
+            case Stage::KillerMoves: {
+                while(killer_index < killers.size()) {
+                    const auto killer = killers[killer_index++];
+                    // Killers come from sibling nodes, they must still
+                    // be quiet and legal here
+                    if(killer.is_none()
+                        || killer == hash_move
+                        || (killer_index == 2 && killer == killers[0])
+                        || killer.is_promotion()
+                        || killer.is_en_passant()
+                        || game.board.at(killer.to_square()).kind() != NONE)
+                    {
+                        continue;
+                    }
+                    const auto legal = find_legal_move(game.board, us, game.castling_state(),
+                        game.en_passant_square(), killer);
+                    if(legal.has_value()) {
+                        move = *legal;
+                        return true;
+                    }
+                }
+                stage = Stage::GenerateQuiets;
+                [[fallthrough]];
+            }
+            case Stage::GenerateQuiets: {
+                generate(MoveGen::Quiets);
+                stage = Stage::Quiets;
+                [[fallthrough]];
+            }
+            case Stage::Quiets: {
+                if(select(move))
+                    return true;
+                current = 0;
+                stage = Stage::BadCaptures;
+                [[fallthrough]];
+            }
+            case Stage::BadCaptures: {
+                // Already in MVV-LVA order
+                if(current < bad_captures_end) {
+                    move = moves[current++];
+                    return true;
+                }
+                stage = Stage::Done;
+                [[fallthrough]];
+            }
+            case Stage::Done:
+                break;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "game.hpp"
+
+namespace lc {
+    constexpr std::string_view STARTING_FEN =
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    // Square in algebraic notation (i.e "e4")
+    std::string square_name(Square);
+    std::optional<Square> parse_square(std::string_view);
+    // Move in coordinate notation, as used by UCI (i.e "e2e4", "e7e8q")
+    std::string move_name(const Move&);
+    // Legal move of the side to move from coordinate notation,
+    // std::nullopt if invalid or illegal
+    std::optional<Move> parse_move(const ChessGame&, std::string_view name);
+    // Legal move of the side to move from Standard Algebraic Notation
+    // (i.e "Nbd7", "exd8=Q+", "O-O"), std::nullopt if invalid or
+    // ambiguous. Check and annotation suffixes are ignored
+    std::optional<Move> parse_san(const ChessGame&, std::string_view san);
+
+    // Forsyth-Edwards Notation parsing, std::nullopt if invalid.
+    // Halfmove clock and fullmove number may be omitted
+    std::optional<ChessGame> game_from_fen(std::string_view fen, bool free_game = false);
+    std::optional<BoardState> state_from_fen(std::string_view fen);
+    // Piece placement field only, the remaining fields are ignored
+    std::optional<Board> board_from_fen(std::string_view fen);
+
+    // FEN emitting, en passant square only when it can be captured
+    std::string game_to_fen(const ChessGame&);
+    std::string state_to_fen(const BoardState&);
+    // Piece placement field only
+    std::string board_to_fen(const Board&);
+}
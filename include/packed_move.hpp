@@ -0,0 +1,95 @@
+#pragma once
+
+#include "move.hpp"
+
+// Packed move flags (4 high bits)
+#define PACKED_NORMAL     0b0000
+#define PACKED_CASTLING   0b0001
+#define PACKED_EN_PASSANT 0b0010
+// Promotion flags are 'PACKED_PROMOTION | (kind - KNIGHT)'
+#define PACKED_PROMOTION  0b1000
+
+namespace lc {
+    // 16 bit move encoding: 6 bits from square, 6 bits to square
+    // and 4 bits of flags. The captured piece is not stored, it's
+    // read from the board when needed (and kept in undo records)
+    class PackedMove {
+        private:
+        uint16_t data;
+
+        public:
+        constexpr PackedMove()
+            : data(0) {}
+        constexpr PackedMove(Square from, Square to, uint8_t flags = PACKED_NORMAL)
+            : data(uint16_t(from | (to << 6) | (flags << 12))) {}
+        constexpr explicit PackedMove(const Move&);
+        static constexpr PackedMove from_raw(uint16_t raw);
+
+        // Null move, never generated since 'from == to'
+        static constexpr PackedMove none() { return PackedMove(); }
+
+        // Unpacks into a 'Move', must be called before this move is
+        // applied to 'board' so the captured piece can be read
+        constexpr Move to_move(const Board& board) const;
+
+        constexpr Square from_square() const { return data & 0x3f; }
+        constexpr Square to_square() const { return (data >> 6) & 0x3f; }
+        constexpr Position from() const { return position_of(from_square()); }
+        constexpr Position to() const { return position_of(to_square()); }
+        constexpr uint8_t flags() const { return data >> 12; }
+        constexpr uint16_t raw() const { return data; }
+
+        constexpr bool is_none() const { return data == 0; }
+        constexpr bool is_castling() const { return flags() == PACKED_CASTLING; }
+        constexpr bool is_en_passant() const { return flags() == PACKED_EN_PASSANT; }
+        constexpr bool is_promotion() const { return flags() & PACKED_PROMOTION; }
+        constexpr uint8_t promotion_kind() const { return KNIGHT + (flags() & 0b0011); }
+
+        constexpr bool operator==(const PackedMove& other) const { return data == other.data; }
+        constexpr bool operator!=(const PackedMove& other) const { return data != other.data; }
+    };
+
+    static_assert(sizeof(PackedMove) == 2);
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc {
+    constexpr PackedMove::PackedMove(const Move& move)
+        : data(0)
+    {
+        uint8_t flags = PACKED_NORMAL;
+        move.visit(
+            [&](Move::Normal) {},
+            [&](Move::Promotion arg) {
+                flags = PACKED_PROMOTION | (arg.to.kind() - KNIGHT);
+            },
+            [&](Move::Castling) { flags = PACKED_CASTLING; },
+            [&](Move::EnPassant) { flags = PACKED_EN_PASSANT; }
+        );
+        *this = PackedMove(square_of(move.from()), square_of(move.to()), flags);
+    }
+
+    constexpr PackedMove PackedMove::from_raw(uint16_t raw) {
+        PackedMove move;
+        move.data = raw;
+        return move;
+    }
+
+    constexpr Move PackedMove::to_move(const Board& board) const {
+        switch(flags()) {
+            case PACKED_CASTLING:
+                return Move::castling(from(), to());
+            case PACKED_EN_PASSANT:
+                return Move::en_passant(from(), to());
+            case PACKED_NORMAL:
+                return Move::normal(from(), to(), board.at(to_square()));
+        }
+        const auto color = board.at(from_square()).color();
+        return Move::promotion(
+            from(),
+            to(),
+            Piece(promotion_kind() | color),
+            board.at(to_square()));
+    }
+}
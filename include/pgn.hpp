@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "archive.hpp"
+#include "game.hpp"
+
+namespace lc {
+    struct PgnGame {
+        // Position in the input, counting skipped games
+        size_t  index;
+        // Tag pairs in input order, views are only valid during the
+        // callback
+        std::vector<std::pair<std::string_view,std::string_view>> tags;
+        // Replayed game, at its final position
+        ChessGame game;
+        uint8_t   result;
+    };
+
+    struct PgnStats {
+        size_t games = 0;
+        // Games skipped for an invalid FEN tag or an illegal or
+        // ambiguous move
+        size_t invalid_games = 0;
+        size_t moves = 0;
+    };
+
+    // Called in input order, one game at a time, from any of the
+    // worker threads
+    using PgnCallback = std::function<void(const PgnGame&)>;
+
+    // Streams PGN text in chunks split at game boundaries, games are
+    // parsed and replayed by 'threads' workers (0 for one per hardware
+    // thread) while the next chunks are read
+    PgnStats read_pgn(std::istream& input, const PgnCallback& callback, unsigned threads = 0);
+    // std::nullopt if the file can't be opened
+    std::optional<PgnStats> read_pgn_file(
+        const std::string& path,
+        const PgnCallback& callback,
+        unsigned threads = 0);
+    // Writes every valid game of a PGN file into a new archive,
+    // std::nullopt if either file can't be opened or written
+    std::optional<PgnStats> pgn_to_archive(
+        const std::string& pgn_path,
+        const std::string& archive_path,
+        unsigned threads = 0);
+
+    // Single threaded parsing of complete games in memory, as done by
+    // each worker. Game indices start at 0
+    PgnStats parse_pgn_games(
+        std::string_view text,
+        const std::function<void(PgnGame&&)>& on_game);
+}
\ No newline at end of file
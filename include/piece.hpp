@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #define NONE   0
 #define PAWN   1
 #define KNIGHT 2
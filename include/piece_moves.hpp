@@ -1,10 +1,11 @@
 #pragma once
 
-#include <vector>
 #include <algorithm>
 #include <optional>
 
-#include "move.hpp"
+#include "move_list.hpp"
+#include "packed_move.hpp"
+#include "trace.hpp"
 
 #define IN_BOUNDS(pos) (pos[0] <= 7 && pos[1] <= 7)
 
@@ -14,39 +15,98 @@
 #define BLACK_KINGSIDE_ROOK_MOVED_BIT  0b001000
 #define BLACK_KING_MOVED_BIT           0b010000
 #define BLACK_QUEENSIDE_ROOK_MOVED_BIT 0b100000
+#define CASTLING_STATE_MASK            0b111111
 
 namespace lc {
+    // Castling state bits of each color, indexed by color index:
+    // { queenside rook, king, kingside rook }
+    constexpr uint8_t CASTLING_BITS[2][3] = {
+        { 
+            WHITE_QUEENSIDE_ROOK_MOVED_BIT , 
+            WHITE_KING_MOVED_BIT      , 
+            WHITE_KINGSIDE_ROOK_MOVED_BIT
+        },
+        { 
+            BLACK_QUEENSIDE_ROOK_MOVED_BIT , 
+            BLACK_KING_MOVED_BIT      , 
+            BLACK_KINGSIDE_ROOK_MOVED_BIT 
+        }
+    };
+
     using PositionDiff = std::array<int8_t,2>;
     inline PositionDiff position_diff(
         const Position& from,
         const Position& to);
+    // Appends a normal move to each square set in 'targets'
+    inline void append_targets(
+        const Board& board,
+        const Position& from,
+        Bitboard targets,
+        MoveList& moves);
 
-    inline std::vector<Move> pawn_moves(
+    // Pseudo-legal moves of a single piece: moves leaving the own king
+    // in check are included, 'generate_legal_moves' filters them
+    inline void pawn_moves(
         const Board& board,
         const Piece& piece,
         const Position& pos,
-        const std::optional<Move>& previous_move);
-    inline std::vector<Move> knight_moves(
+        Square en_passant,
+        MoveList& moves);
+    inline void knight_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos);
-    inline std::vector<Move> bishop_moves(
+        const Position& pos,
+        MoveList& moves);
+    inline void bishop_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos);
-    inline std::vector<Move> rook_moves(
+        const Position& pos,
+        MoveList& moves);
+    inline void rook_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos);
-    inline std::vector<Move> queen_moves(
+        const Position& pos,
+        MoveList& moves);
+    inline void queen_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos);
-    inline std::vector<Move> king_moves(
+        const Position& pos,
+        MoveList& moves);
+    inline void king_moves(
         const Board& board,
         const Piece& piece,
         const Position& pos,
-        uint8_t state);
+        uint8_t state,
+        MoveList& moves);
+
+    // Subsets of the legal moves, for staged generation
+    enum class MoveGen : uint8_t {
+        All,
+        // Captures, en passant and promotions
+        Captures,
+        // Everything else, castling included
+        Quiets
+    };
+
+    // Every legal move of color 'us' of kind 'gen', only for the
+    // pieces on 'from' squares. Checkers and pinned pieces are
+    // computed up front, so moves never need to be tried on the board
+    inline void generate_legal_moves(
+        const Board& board,
+        Color us,
+        uint8_t state,
+        Square en_passant,
+        MoveList& moves,
+        MoveGen gen = MoveGen::All,
+        Bitboard from = ~Bitboard(0));
+    // The legal move matching 'packed' (i.e a hash move to be
+    // validated), std::nullopt if there's none
+    inline std::optional<Move> find_legal_move(
+        const Board& board,
+        Color us,
+        uint8_t state,
+        Square en_passant,
+        PackedMove packed);
 }
 
 /////////////// Implementation ///////////////
@@ -63,130 +123,88 @@ namespace lc {
     }
 
 
-    std::vector<Move> pawn_moves(
+    void pawn_moves(
         const Board& board,
         const Piece& piece,
         const Position& from,
-        const std::optional<Move>& previous_move)
+        Square en_passant,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
-        
         // Only in pawn the direction of the moveset matters
         const int8_t direction = piece.is_white() ? -1 : 1;
+        const uint8_t to_y = uint8_t(from[1] + direction);
+        if(to_y > 7) [[unlikely]]
+            return;
+        // Target row squares, as row masks
+        const auto to_row = board.board_data[to_y];
+        const uint8_t empty = ~swar::occupancy(to_row);
+        const uint8_t enemy = swar::color_mask(to_row, piece.color() ^ BLACK);
+        const bool promotion = (piece.is_white() && to_y == 0)
+            || (piece.is_black() && to_y == 7);
+
         // Normal
         {
-            const auto to = Position{from[0], uint8_t(from[1] + direction)};
-            
-            if(IN_BOUNDS(to) && board.at(to).kind() == NONE) {
+            const auto to = Position{from[0], to_y};
+            if(empty & (1 << from[0])) {
                 // Check if there's promotion
-                if((piece.is_white() && to[1] == 0)
-                    || (piece.is_black() && to[1] == 7)) {
-                    moves.emplace_back(Move::promotion(from, to, QUEEN));
+                if(promotion) {
+                    moves.emplace_back(Move::promotion(from, to, queen(piece.color())));
                 }
                 else {
                     moves.emplace_back(Move::normal(from, to));
                 }
             }
         }
-        
+
         // First double
         {
-            const auto to1 = Position{from[0], uint8_t(from[1] + direction)};
-            const auto to2 = Position{from[0], uint8_t(from[1] + 2*direction)};
-            // Position to1 is valid and has no pieces
-            if(IN_BOUNDS(to1) && board.at(to1).kind() == NONE
-            // Position to2 is valid and has no pieces
-                && IN_BOUNDS(to2) && board.at(to2).kind() == NONE
-            // Is first move of piece
-                && ((piece.is_white() && from[1] == 6)
-                    || (piece.is_black() && from[1] == 1)))
+            // Is first move of piece, both squares ahead have no pieces
+            if(((piece.is_white() && from[1] == 6)
+                    || (piece.is_black() && from[1] == 1))
+                && (empty & (1 << from[0]))
+                && (~swar::occupancy(board.board_data[to_y + direction]) & (1 << from[0])))
             {
-                moves.emplace_back(Move::normal(from, to2));
+                moves.emplace_back(Move::normal(from, {from[0], uint8_t(to_y + direction)}));
             }
         }
-        
+
         // Capture
         {
-            const auto to1 = Position{
-                uint8_t(from[0] - 1),
-                uint8_t(from[1] + direction)
-            };
-            const auto to2 = Position{
-                uint8_t(from[0] + 1),
-                uint8_t(from[1] + direction)
-            };
-            
-            // Left capture
-            if(IN_BOUNDS(to1)) {
-                const auto to1_piece = board.at(to1);
-                // Position on diagonal left has opposite color piece
-                if(to1_piece.color() != piece.color()) {
-                    // Check if promotion
-                    if((piece.is_white() && to1[1] == 0)
-                        || (piece.is_black() && to1[1] == 7)) {
-                        moves.emplace_back(Move::promotion(from, to1, QUEEN, to1_piece));
-                    }
-                    else {
-                        moves.emplace_back(Move::normal(from, to1, to1_piece));
-                    }
+            // Diagonal squares with an opposite color piece, the
+            // shift drops the ones outside the board
+            uint8_t targets = enemy & ((0b101 << from[0]) >> 1);
+            while(targets) {
+                const auto to = Position{uint8_t(std::countr_zero(targets)), to_y};
+                targets &= targets - 1;
+                const auto to_piece = board.at(to);
+                // Check if promotion
+                if(promotion) {
+                    moves.emplace_back(Move::promotion(from, to, queen(piece.color()), to_piece));
                 }
-            }
-
-            // Right capture
-            if(IN_BOUNDS(to2)) {
-                const auto to2_piece = board.at(to2);
-                // Position on diagonal right has opposite color piece
-                if(to2_piece.color() != piece.color()) {
-                    // Check if promotion
-                    if((piece.is_white() && to2[1] == 0)
-                        || (piece.is_black() && to2[1] == 7)) {
-                        moves.emplace_back(Move::promotion(from, to2, QUEEN, to2_piece));
-                    }
-                    else {
-                        moves.emplace_back(Move::normal(from, to2, to2_piece));
-                    }
+                else {
+                    moves.emplace_back(Move::normal(from, to, to_piece));
                 }
             }
         }
-        
+
         // En Passant
         {
-            // If there's no previous move, en passant can't be done
-            if(previous_move.has_value()) {
-                const auto to1 = Position{
-                    uint8_t(from[0] - 1),
-                    uint8_t(from[1] + direction)
-                };
-                const auto to2 = Position{
-                    uint8_t(from[0] + 1),
-                    uint8_t(from[1] + direction)
-                };
-                auto previous_move_diff = position_diff(previous_move->from(), previous_move->to());
-                if(board.at(previous_move->to()).kind() == PAWN
-                    && std::abs(previous_move_diff[1]) == 2)
-                {
-                    // NOTE: En passant can only be performed at one side in a turn
-                    // Previous move is a pawn with diff == 2 with position.x == from.x-1 
-                    if(previous_move->to()[0] == from[0]-1) {
-                        moves.emplace_back(Move::en_passant(from, to1));
-                    }
-                    // Previous move is a pawn with diff == 2 with position.x == from.x+1
-                    else if(previous_move->to()[0] == from[0]+1) {
-                        moves.emplace_back(Move::en_passant(from, to2));
-                    }
-                }
+            // 'en_passant' is the square skipped by the pawn that
+            // just made a double move, if any
+            if(en_passant != NO_SQUARE
+                && (pawn_attacks[color_index(piece.color())][square_of(from)] & square_bb(en_passant)))
+            {
+                moves.emplace_back(Move::en_passant(from, position_of(en_passant)));
             }
         }
-
-        return moves;
     }
 
-    std::vector<Move> knight_moves(
+    void knight_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos)
+        const Position& pos,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
         static const std::array<int8_t,2> diffs[] = {
             { 1, 2}, {-1,-2}, { 1,-2}, {-1, 2},
             { 2, 1}, {-2,-1}, { 2,-1}, {-2, 1}
@@ -206,147 +224,60 @@ namespace lc {
                 }
             }
         }
-        return moves;
     }
 
-    std::vector<Move> bishop_moves(
+    inline void append_targets(
+        const Board& board,
+        const Position& from,
+        Bitboard targets,
+        MoveList& moves)
+    {
+        while(targets) {
+            const auto to = pop_lsb(targets);
+            moves.emplace_back(Move::normal(from, position_of(to), board.at(to)));
+        }
+    }
+
+    void bishop_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos)
+        const Position& pos,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
-        auto diretional_check = [&](int8_t x_dir, int8_t y_dir) {
-            Piece to_piece = NONE;
-            for(int8_t i = 1; i < 8; ++i) {
-                auto to = Position{
-                    uint8_t(pos[0]+(i*x_dir)),
-                    uint8_t(pos[1]+(i*y_dir))
-                };
-                if(!IN_BOUNDS(to))
-                    break;
-                to_piece = board.at(to);
-                if(to_piece.kind() == NONE) {
-                    moves.emplace_back(Move::normal(pos, to));
-                }
-                else if(to_piece.color() != piece.color()) {
-                    moves.emplace_back(Move::normal(pos, to, to_piece));
-                    break;
-                }
-                else {
-                    break;
-                }
-            }
-        };
-        
-        // North East
-        diretional_check(1,-1);
-        // North West
-        diretional_check(-1,-1);
-        // South East
-        diretional_check(1,1);
-        // South West
-        diretional_check(-1,1);
-
-        return moves;
+        const auto targets = bishop_attacks(square_of(pos), board.occupancy())
+            & ~board.pieces(piece.color());
+        append_targets(board, pos, targets, moves);
     }
 
-    std::vector<Move> rook_moves(
+    void rook_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos)
+        const Position& pos,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
-        auto diretional_check = [&](int8_t x_dir, int8_t y_dir) {
-            Piece to_piece = NONE;
-            for(int8_t i = 1; i < 8; ++i) {
-                auto to = Position{
-                    uint8_t(pos[0]+(i*x_dir)),
-                    uint8_t(pos[1]+(i*y_dir))
-                };
-                if(!IN_BOUNDS(to))
-                    break;
-                to_piece = board.at(to);
-                if(to_piece.kind() == NONE) {
-                    moves.emplace_back(Move::normal(pos, to));
-                }
-                else if(to_piece.color() != piece.color()) {
-                    moves.emplace_back(Move::normal(pos, to, to_piece));
-                    break;
-                }
-                else {
-                    break;
-                }
-            }
-        };
-        
-        // North
-        diretional_check(0,-1);
-        // South
-        diretional_check(0,1);
-        // East
-        diretional_check(1,0);
-        // West
-        diretional_check(-1,0);
-
-        return moves;
+        const auto targets = rook_attacks(square_of(pos), board.occupancy())
+            & ~board.pieces(piece.color());
+        append_targets(board, pos, targets, moves);
     }
 
-    std::vector<Move> queen_moves(
+    void queen_moves(
         const Board& board,
         const Piece& piece,
-        const Position& pos)
+        const Position& pos,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
-        auto diretional_check = [&](int8_t x_dir, int8_t y_dir) {
-            Piece to_piece = NONE;
-            for(int8_t i = 1; i < 8; ++i) {
-                auto to = Position{
-                    uint8_t(pos[0]+(i*x_dir)),
-                    uint8_t(pos[1]+(i*y_dir))
-                };
-                if(!IN_BOUNDS(to))
-                    break;
-                to_piece = board.at(to);
-                if(to_piece.kind() == NONE) {
-                    moves.emplace_back(Move::normal(pos, to));
-                }
-                else if(to_piece.color() != piece.color()) {
-                    moves.emplace_back(Move::normal(pos, to, to_piece));
-                    break;
-                }
-                else {
-                    break;
-                }
-            }
-        };
-        
-        // North
-        diretional_check(0,-1);
-        // South
-        diretional_check(0,1);
-        // East
-        diretional_check(1,0);
-        // West
-        diretional_check(-1,0);
-        // North East
-        diretional_check(1,-1);
-        // North West
-        diretional_check(-1,-1);
-        // South East
-        diretional_check(1,1);
-        // South West
-        diretional_check(-1,1);
-
-        return moves;
+        const auto targets = queen_attacks(square_of(pos), board.occupancy())
+            & ~board.pieces(piece.color());
+        append_targets(board, pos, targets, moves);
     }
 
-    std::vector<Move> king_moves(
+    void king_moves(
         const Board& board,
         const Piece& piece,
         const Position& pos,
-        uint8_t state)
+        uint8_t state,
+        MoveList& moves)
     {
-        std::vector<Move> moves;
         // Normal
         static const std::array<int8_t,2> diffs[] = {
             { 1, 0}, {-1, 0}, { 0,-1}, { 0, 1},
@@ -368,54 +299,232 @@ namespace lc {
         }
         // Castling
         {
-            static const int8_t info_bits[2][3] = {
-                { 
-                    WHITE_QUEENSIDE_ROOK_MOVED_BIT , 
-                    WHITE_KING_MOVED_BIT      , 
-                    WHITE_KINGSIDE_ROOK_MOVED_BIT
-                },
-                { 
-                    BLACK_QUEENSIDE_ROOK_MOVED_BIT , 
-                    BLACK_KING_MOVED_BIT      , 
-                    BLACK_KINGSIDE_ROOK_MOVED_BIT 
-                }
+            auto color = color_index(piece.color());
+            const Color them = piece.color() ^ BLACK;
+            // King can't castle out of, through or into check
+            const auto safe = [&](uint8_t x) {
+                return !board.is_attacked(square_of({x, pos[1]}), them);
             };
-            
-            // TODO: Do this only if there's no check
-            auto color = piece.color();
-            if(!(state & info_bits[color][1])) {
-                bool between_empty = true;
-                if(!(state & info_bits[color][0])) {
-                    // Check if positions in between have no pieces
-                    for(int8_t i = 1; i < 4 && between_empty; ++i) {
-                        auto to = Position{
-                            uint8_t(pos[0] - i),
-                            pos[1]
-                        };
-                        between_empty = board.at(to).kind() == NONE;
-                    }
-                    // If yes 
-                    if(between_empty) {
-                        moves.emplace_back(Move::castling(pos, {uint8_t(pos[0]-2), pos[1]}));
-                    }
+            // Same conditions as 'generate_legal_moves': king on its
+            // starting square and the rook still in its corner
+            const uint8_t row = piece.is_white() ? 7 : 0;
+            if(!(state & CASTLING_BITS[color][1])
+                && pos == Position{4, row}
+                && safe(pos[0]))
+            {
+                // Squares in between have no pieces, checked on the
+                // whole row at once
+                const uint8_t occupied = swar::occupancy(board.board_data[row]);
+                if(!(state & CASTLING_BITS[color][0])
+                    && board.at(Position{0, row}).raw() == (ROOK | piece.color())
+                    && !(occupied & 0b00001110)
+                    && safe(pos[0] - 1) && safe(pos[0] - 2))
+                {
+                    moves.emplace_back(Move::castling(pos, {uint8_t(pos[0]-2), pos[1]}));
+                }
+                if(!(state & CASTLING_BITS[color][2])
+                    && board.at(Position{7, row}).raw() == (ROOK | piece.color())
+                    && !(occupied & 0b01100000)
+                    && safe(pos[0] + 1) && safe(pos[0] + 2))
+                {
+                    moves.emplace_back(Move::castling(pos, {uint8_t(pos[0]+2), pos[1]}));
+                }
+            }
+        }
+    }
+
+    void generate_legal_moves(
+        const Board& board,
+        Color us,
+        uint8_t state,
+        Square en_passant,
+        MoveList& moves,
+        MoveGen gen,
+        Bitboard from_mask)
+    {
+        const Color them = us ^ BLACK;
+        const auto own = board.pieces(us);
+        const auto enemy = board.pieces(them);
+        const auto occupancy = own | enemy;
+        const auto king_sq = lsb(board.pieces(us, KING));
+        const auto king_pos = position_of(king_sq);
+        const auto checkers = board.attackers_to(king_sq, occupancy) & enemy;
+        // Destination squares allowed by 'gen', pawns aside
+        const auto gen_mask = gen == MoveGen::Captures
+            ? enemy
+            : (gen == MoveGen::Quiets ? ~occupancy : ~own);
+        // Start of the moves of the current piece kind, for tracing
+        [[maybe_unused]] auto traced_size = moves.size();
+
+        // King
+        if(from_mask & square_bb(king_sq)) {
+            // King is removed from the occupancy so it can't
+            // step back along the ray of a checking slider
+            const auto occupancy_no_king = occupancy ^ square_bb(king_sq);
+            auto targets = king_attacks[king_sq] & gen_mask;
+            while(targets) {
+                const auto to = pop_lsb(targets);
+                if(!(board.attackers_to(to, occupancy_no_king) & enemy))
+                    moves.emplace_back(Move::normal(king_pos, position_of(to), board.at(to)));
+            }
+            LC_TRACE_COUNT(generated[KING], moves.size() - traced_size);
+        }
+
+        // In double check only the king can move
+        if(popcount(checkers) > 1)
+            return;
+
+        // Squares that capture or block the checker
+        const auto check_mask = checkers
+            ? between(king_sq, lsb(checkers)) | checkers
+            : ~Bitboard(0);
+
+        // Own pieces alone between the king and an enemy slider
+        Bitboard pinned = 0;
+        {
+            const auto diagonal = board.kind_bb[BISHOP] | board.kind_bb[QUEEN];
+            const auto straight = board.kind_bb[ROOK] | board.kind_bb[QUEEN];
+            auto snipers = ((bishop_attacks(king_sq, 0) & diagonal)
+                | (rook_attacks(king_sq, 0) & straight)) & enemy;
+            while(snipers) {
+                const auto blockers = between(king_sq, pop_lsb(snipers)) & occupancy;
+                if(popcount(blockers) == 1)
+                    pinned |= blockers & own;
+            }
+        }
+        // Pinned pieces can only move along the line with their king
+        const auto move_mask = [&](Square from) {
+            return (pinned & square_bb(from))
+                ? check_mask & line(king_sq, from)
+                : check_mask;
+        };
+
+        // Knight, bishop, rook and queen
+        for(uint8_t kind = KNIGHT; kind <= QUEEN; ++kind) {
+            traced_size = moves.size();
+            auto pieces = board.pieces(us, kind) & from_mask;
+            while(pieces) {
+                const auto from = pop_lsb(pieces);
+                Bitboard attacks = 0;
+                switch(kind) {
+                    case KNIGHT: attacks = knight_attacks[from]; break;
+                    case BISHOP: attacks = bishop_attacks(from, occupancy); break;
+                    case ROOK:   attacks = rook_attacks(from, occupancy); break;
+                    case QUEEN:  attacks = queen_attacks(from, occupancy); break;
+                }
+                append_targets(board, position_of(from), attacks & gen_mask & move_mask(from), moves);
+            }
+            LC_TRACE_COUNT(generated[kind], moves.size() - traced_size);
+        }
+
+        // Pawn
+        {
+            // Square index offset of a pawn step
+            const int8_t step = us == WHITE ? -8 : 8;
+            const uint8_t start_row = us == WHITE ? 6 : 1;
+            const uint8_t promotion_row = us == WHITE ? 0 : 7;
+            // Captures and promotions
+            const auto noisy = enemy | (Bitboard(0xff) << (promotion_row * 8));
+            const auto pawn_mask = gen == MoveGen::Captures
+                ? noisy
+                : (gen == MoveGen::Quiets ? ~noisy : ~Bitboard(0));
+            traced_size = moves.size();
+
+            auto pawns = board.pieces(us, PAWN) & from_mask;
+            while(pawns) {
+                const auto from = pop_lsb(pawns);
+                const auto from_pos = position_of(from);
+
+                auto targets = pawn_attacks[color_index(us)][from] & enemy;
+                const auto push = Square(from + step);
+                if(!(occupancy & square_bb(push))) {
+                    targets |= square_bb(push);
+                    const auto double_push = Square(push + step);
+                    if(from_pos[1] == start_row && !(occupancy & square_bb(double_push)))
+                        targets |= square_bb(double_push);
                 }
-                if(!(state & info_bits[color][2])) {
-                    between_empty = true;
-                    // Check if positions in between have no pieces
-                    for(int8_t i = 1; i < 3 && between_empty; ++i) {
-                        auto to = Position{
-                            uint8_t(pos[0] + i),
-                            pos[1]
-                        };
-                        between_empty = board.at(to).kind() == NONE;
+                targets &= move_mask(from) & pawn_mask;
+
+                while(targets) {
+                    const auto to = pop_lsb(targets);
+                    const auto to_pos = position_of(to);
+                    const auto capture = board.at(to);
+                    if(to_pos[1] == promotion_row) {
+                        for(uint8_t kind = QUEEN; kind >= KNIGHT; --kind)
+                            moves.emplace_back(Move::promotion(from_pos, to_pos, Piece(kind | us), capture));
                     }
-                    // If yes 
-                    if(between_empty) {
-                        moves.emplace_back(Move::castling(pos, {uint8_t(pos[0]+2), pos[1]}));
+                    else {
+                        moves.emplace_back(Move::normal(from_pos, to_pos, capture));
                     }
                 }
+
+                // En passant removes two pieces from the same row, so
+                // it's validated by looking at the king attackers
+                // after the capture
+                if(en_passant != NO_SQUARE
+                    && gen != MoveGen::Quiets
+                    && (pawn_attacks[color_index(us)][from] & square_bb(en_passant)))
+                {
+                    const auto captured = Square(en_passant - step);
+                    const auto occupancy_after = (occupancy ^ square_bb(from) ^ square_bb(captured))
+                        | square_bb(en_passant);
+                    const auto attackers = board.attackers_to(king_sq, occupancy_after)
+                        & enemy & ~square_bb(captured);
+                    if(!attackers)
+                        moves.emplace_back(Move::en_passant(from_pos, position_of(en_passant)));
+                }
             }
+            LC_TRACE_COUNT(generated[PAWN], moves.size() - traced_size);
         }
-        return moves;
+
+        // Castling
+        if(!checkers && gen != MoveGen::Captures && (from_mask & square_bb(king_sq))) {
+            traced_size = moves.size();
+            const auto& bits = CASTLING_BITS[color_index(us)];
+            const uint8_t row = king_pos[1];
+            const uint8_t occupied = swar::occupancy(board.board_data[row]);
+            const auto safe = [&](uint8_t x) {
+                return !(board.attackers_to(square_of({x, row}), occupancy) & enemy);
+            };
+
+            if(!(state & bits[1]) && king_pos == Position{4, uint8_t(us == WHITE ? 7 : 0)}) {
+                // Queenside
+                if(!(state & bits[0])
+                    && board.at(Position{0, row}).raw() == (ROOK | us)
+                    && !(occupied & 0b00001110)
+                    && safe(2) && safe(3))
+                {
+                    moves.emplace_back(Move::castling(king_pos, {2, row}));
+                }
+                // Kingside
+                if(!(state & bits[2])
+                    && board.at(Position{7, row}).raw() == (ROOK | us)
+                    && !(occupied & 0b01100000)
+                    && safe(5) && safe(6))
+                {
+                    moves.emplace_back(Move::castling(king_pos, {6, row}));
+                }
+            }
+            LC_TRACE_COUNT(generated[KING], moves.size() - traced_size);
+        }
+    }
+
+    std::optional<Move> find_legal_move(
+        const Board& board,
+        Color us,
+        uint8_t state,
+        Square en_passant,
+        PackedMove packed)
+    {
+        if(board.at(packed.from_square()).color() != us)
+            return std::nullopt;
+        // Only the moves of the piece being moved
+        MoveList moves;
+        generate_legal_moves(board, us, state, en_passant, moves,
+            MoveGen::All, square_bb(packed.from_square()));
+        for(const auto& move : moves)
+            if(PackedMove(move) == packed)
+                return move;
+        return std::nullopt;
     }
 }
\ No newline at end of file
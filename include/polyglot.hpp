@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "game.hpp"
+#include "mapped_file.hpp"
+
+// Polyglot opening books: files of 16 byte big endian entries sorted
+// by position key, probed in place from a memory map
+//   | key (64) | move (16) | weight (16) | learn (32) |
+//   - key: xor of the standard Polyglot table of 781 random numbers,
+//     one per piece on square, castling right, en passant file and
+//     white to move
+//   - move: to square (6), from square (6), promotion (3), squares
+//     from a1 to h8. Castling is encoded as the king taking its rook
+
+namespace lc::polyglot {
+    constexpr size_t RANDOM_COUNT = 781;
+
+    struct BookEntry {
+        uint64_t key;
+        uint16_t move;
+        uint16_t weight;
+        uint32_t learn;
+    };
+
+    struct BookMove {
+        Move     move;
+        uint16_t weight;
+    };
+
+    uint64_t key(const ChessGame& game);
+    uint16_t encode_move(const Move& move);
+    // Legal move of 'game' encoded by 'move', std::nullopt if none
+    std::optional<Move> decode_move(const ChessGame& game, uint16_t move);
+
+    // Read only book, nothing is loaded up front: probes binary
+    // search the mapped entries
+    class Book {
+        private:
+        MappedFile file;
+        size_t     entry_count;
+
+        public:
+        Book();
+        // Check 'is_open' for failure
+        explicit Book(const std::string& path);
+
+        // False if the file can't be mapped or isn't a whole number
+        // of entries
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const { return file.is_open(); }
+
+        size_t size() const { return entry_count; }
+        BookEntry operator[](size_t entry) const;
+
+        // Legal book moves of the position, in book order (highest
+        // weight first for books sorted by weight)
+        std::vector<BookMove> probe(const ChessGame& game) const;
+        // Book move chosen with probability proportional to its
+        // weight, 'random' uniformly distributed (i.e from a
+        // std::mt19937_64). std::nullopt out of book
+        std::optional<Move> pick(const ChessGame& game, uint64_t random) const;
+
+        private:
+        // First entry with key not less than 'key'
+        size_t lower_bound(uint64_t key) const;
+    };
+
+    // Accumulates weighted moves and writes a book sorted by key, then
+    // by decreasing weight
+    class BookBuilder {
+        private:
+        struct Record {
+            uint64_t key;
+            uint16_t move;
+            // Times played, for filtering. Saturates
+            uint16_t count;
+            uint32_t weight;
+        };
+
+        std::vector<Record> records;
+        // Size after the last merge, records are merged again once
+        // the vector doubles
+        size_t              merged_size;
+
+        public:
+        BookBuilder();
+
+        // 'move' played in 'game', weighted by its outcome (Polyglot
+        // scores 2 for a win, 1 for a draw)
+        void add(const ChessGame& game, const Move& move, uint32_t weight);
+        // Adds the first 'plies' moves of a game from its starting
+        // position, weighted by its result (RESULT_* of archive.hpp)
+        // from the point of view of the side moving. Stops at the
+        // first illegal move, false if there's one
+        bool add_game(ChessGame start, std::span<const PackedMove> moves, uint8_t result, size_t plies);
+
+        // Drops moves played less than 'min_count' times and moves
+        // without weight. Weights of each position are scaled down to
+        // fit 16 bits. False if the file can't be written
+        bool write(const std::string& path, uint16_t min_count = 1);
+        // Distinct position and move pairs so far
+        size_t size();
+
+        private:
+        // Sorts records and sums the ones of the same key and move
+        void merge();
+    };
+}
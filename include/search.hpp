@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "game.hpp"
+#include "transposition.hpp"
+
+namespace lc::tablebase {
+    class Tablebases;
+}
+
+namespace lc {
+    constexpr int MAX_PLY = 128;
+    constexpr int SCORE_INFINITE = 32001;
+    constexpr int SCORE_MATE = 32000;
+    // Scores above are mates found within the search horizon
+    constexpr int SCORE_MATE_IN_MAX_PLY = SCORE_MATE - MAX_PLY;
+
+    struct SearchLimits {
+        int      depth = MAX_PLY - 1;
+        // Limits below are disabled when 0
+        uint64_t nodes = 0;
+        // Milliseconds
+        int64_t  movetime = 0;
+        // Lazy SMP: main thread plus 'threads - 1' helpers, sharing
+        // the transposition table
+        unsigned threads = 1;
+        // Endgames probed below the root, their exact distance to
+        // mate ends the search of the node. nullptr for none
+        const tablebase::Tablebases* tablebases = nullptr;
+    };
+
+    struct SearchResult {
+        std::optional<Move> best_move;
+        // Centipawns from the side to move point of view
+        int               score = 0;
+        int               depth = 0;
+        uint64_t          nodes = 0;
+        int64_t           time = 0;
+        std::vector<Move> pv;
+    };
+
+    // Called by the main thread after each completed iteration
+    using SearchCallback = std::function<void(const SearchResult&)>;
+
+    // Iterative deepening principal variation search of the side to
+    // move. Runs until a limit is reached or 'stop' is set, the
+    // result of the deepest completed iteration is returned. Nodes
+    // and node limit count every thread
+    SearchResult search(
+        const ChessGame& game,
+        TranspositionTable& tt,
+        const SearchLimits& limits,
+        const std::atomic<bool>& stop,
+        const SearchCallback& on_iteration = {});
+}
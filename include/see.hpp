@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+
+#include "move.hpp"
+
+namespace lc {
+    // Used for capture ordering and exchanges. The king is worth more
+    // than all the material, so exchanges never give it away
+    constexpr int PIECE_VALUES[8] = { 0, 100, 320, 330, 500, 900, 20000, 0 };
+
+    // Static exchange evaluation: material won by the side making
+    // 'move' once every capture on its target square is resolved. Both
+    // sides recapture with their least valuable attacker and may stop
+    // when going on loses material. Sliders behind the capturing pieces
+    // join in, pins are ignored. 0 for quiet moves and castling
+    inline int see(const Board& board, const Move& move);
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc {
+    inline int see(const Board& board, const Move& move) {
+        const auto from = square_of(move.from());
+        const auto to = square_of(move.to());
+        auto occupancy = board.occupancy() ^ square_bb(from);
+        // Value of the victim, and of the piece left on the target
+        // square for the opponent to capture
+        int gain = 0;
+        int on_square = PIECE_VALUES[board.at(from).kind()];
+        bool exchange = true;
+        move.visit(
+            [&](Move::Normal arg) {
+                gain = PIECE_VALUES[arg.capture.kind()];
+                exchange = arg.capture.kind() != NONE;
+            },
+            [&](Move::Promotion arg) {
+                gain = PIECE_VALUES[arg.capture.kind()]
+                    + PIECE_VALUES[arg.to.kind()] - PIECE_VALUES[PAWN];
+                on_square = PIECE_VALUES[arg.to.kind()];
+            },
+            [&](Move::Castling) { exchange = false; },
+            [&](Move::EnPassant) {
+                gain = PIECE_VALUES[PAWN];
+                // Captured pawn is beside the capturing one
+                occupancy ^= square_bb(square_of({move.to()[0], move.from()[1]}));
+            }
+        );
+        if(!exchange)
+            return 0;
+
+        const auto diagonal = board.kind_bb[BISHOP] | board.kind_bb[QUEEN];
+        const auto straight = board.kind_bb[ROOK] | board.kind_bb[QUEEN];
+        auto attackers = board.attackers_to(to, occupancy) & occupancy;
+        Color side = board.at(from).color() ^ BLACK;
+
+        // Swap list, 'gains[d]' is the balance for the side capturing
+        // at depth 'd' if the exchange stops after its capture. Folded
+        // back from the end, each side only captures if it gains by it
+        int gains[32];
+        int depth = 0;
+        gains[0] = gain;
+        while(true) {
+            const auto side_attackers = attackers & board.pieces(side);
+            if(!side_attackers)
+                break;
+            // Least valuable attacker
+            uint8_t kind = PAWN;
+            while(!(side_attackers & board.kind_bb[kind]))
+                ++kind;
+
+            ++depth;
+            gains[depth] = on_square - gains[depth - 1];
+            // Capturing the king ends it, the capture before was illegal
+            if(on_square == PIECE_VALUES[KING])
+                break;
+
+            occupancy ^= square_bb(lsb(side_attackers & board.kind_bb[kind]));
+            // Sliders behind the capturing piece can now reach the square
+            if(kind == PAWN || kind == BISHOP || kind == QUEEN)
+                attackers |= bishop_attacks(to, occupancy) & diagonal;
+            if(kind == ROOK || kind == QUEEN)
+                attackers |= rook_attacks(to, occupancy) & straight;
+            attackers &= occupancy;
+            on_square = PIECE_VALUES[kind];
+            side ^= BLACK;
+            if(depth == 31)
+                break;
+        }
+
+        for(; depth > 0; --depth)
+            gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+        return gains[0];
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "piece.hpp"
+
+// SIMD within a register kernels over 'Board::board_data' rows, each
+// byte of a row is a raw piece (kind | color). Results come either as
+// byte masks (0x80 set in the selected bytes) or as 8 bit row masks,
+// bit x for the square on column x, so a row mask shifted by 'y*8'
+// is a bitboard
+
+namespace lc::swar {
+    using Row = uint64_t;
+    using Rows = std::array<Row,8>;
+
+    constexpr Row LOW_BYTES  = 0x0101010101010101;
+    constexpr Row HIGH_BITS  = 0x8080808080808080;
+    constexpr Row LOW_7_BITS = 0x7f7f7f7f7f7f7f7f;
+
+    // Byte masks
+    constexpr Row zero_bytes(Row row);
+    constexpr Row nonzero_bytes(Row row);
+    constexpr Row equal_bytes(Row row, uint8_t value);
+
+    // Gathers the high bit of each byte into an 8 bit row mask
+    constexpr uint8_t to_row_mask(Row byte_mask);
+
+    // Row masks
+    constexpr uint8_t occupancy(Row row);
+    constexpr uint8_t color_mask(Row row, Color color);
+    constexpr uint8_t kind_mask(Row row, uint8_t kind);
+    constexpr uint8_t piece_mask(Row row, const Piece& piece);
+    // Squares holding different pieces
+    constexpr uint8_t diff(Row a, Row b);
+
+    // Whole board, one row at a time
+    constexpr int count(const Rows& rows, const Piece& piece);
+    // Number of pieces indexed by raw piece, index 0 counts empty
+    // squares
+    constexpr std::array<uint8_t,16> piece_counts(const Rows& rows);
+    constexpr uint64_t diff(const Rows& a, const Rows& b);
+    constexpr bool equal(const Rows& a, const Rows& b);
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc::swar {
+    constexpr Row zero_bytes(Row row) {
+        // Adding 0x7f to the low 7 bits carries into the high bit
+        // unless they are all 0, exact since no carry crosses bytes
+        return ~(((row & LOW_7_BITS) + LOW_7_BITS) | row | LOW_7_BITS);
+    }
+
+    constexpr Row nonzero_bytes(Row row) {
+        return (((row & LOW_7_BITS) + LOW_7_BITS) | row) & HIGH_BITS;
+    }
+
+    constexpr Row equal_bytes(Row row, uint8_t value) {
+        return zero_bytes(row ^ (LOW_BYTES * value));
+    }
+
+    constexpr uint8_t to_row_mask(Row byte_mask) {
+        // Each byte high bit lands on bit '56 + byte index'
+        return uint8_t(((byte_mask >> 7) * 0x0102040810204080) >> 56);
+    }
+
+    constexpr uint8_t occupancy(Row row) {
+        return to_row_mask(nonzero_bytes(row));
+    }
+
+    constexpr uint8_t color_mask(Row row, Color color) {
+        // Color bit (COLOR_MASK) moved to the high bit, pieces are
+        // below 0x10 so nothing leaks into the next byte
+        const auto black = (row << 4) & HIGH_BITS;
+        return to_row_mask(nonzero_bytes(row) & (color == BLACK ? black : ~black));
+    }
+
+    constexpr uint8_t kind_mask(Row row, uint8_t kind) {
+        return to_row_mask(equal_bytes(row & (LOW_BYTES * VALUE_MASK), kind));
+    }
+
+    constexpr uint8_t piece_mask(Row row, const Piece& piece) {
+        return to_row_mask(equal_bytes(row, piece.raw()));
+    }
+
+    constexpr uint8_t diff(Row a, Row b) {
+        return to_row_mask(nonzero_bytes(a ^ b));
+    }
+
+    constexpr int count(const Rows& rows, const Piece& piece) {
+        int total = 0;
+        for(const auto row : rows)
+            total += std::popcount(equal_bytes(row, piece.raw()));
+        return total;
+    }
+
+    constexpr std::array<uint8_t,16> piece_counts(const Rows& rows) {
+        std::array<uint8_t,16> counts = {};
+        for(uint8_t raw = 0; raw < 16; ++raw)
+            counts[raw] = uint8_t(count(rows, Piece(raw)));
+        return counts;
+    }
+
+    constexpr uint64_t diff(const Rows& a, const Rows& b) {
+        uint64_t squares = 0;
+        for(std::size_t y = 0; y < 8; ++y)
+            squares |= uint64_t(diff(a[y], b[y])) << (y*8);
+        return squares;
+    }
+
+    constexpr bool equal(const Rows& a, const Rows& b) {
+        Row acc = 0;
+        for(std::size_t y = 0; y < 8; ++y)
+            acc |= a[y] ^ b[y];
+        return acc == 0;
+    }
+}
\ No newline at end of file
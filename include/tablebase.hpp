@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "game.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+// Endgame tablebases: the exact outcome and distance to mate of every
+// position of a material set, without castling rights. One file per
+// set, named after it ("KQvKR.lctb") with white the stronger side:
+//   | header (64) | wdl (2 bits per position) | dtm (8 bits per position) |
+//   - position index: side to move, en passant flag (only for sets
+//     with pawns of both colors), white king square reduced by
+//     symmetry, then 6 bits per square of the other pieces
+//   - wdl: 0 loss, 1 draw, 2 win, 3 unreachable position
+//   - dtm: 0 draw, 255 unreachable, else plies to mate plus one (odd
+//     plies win for the side to move, even plies lose)
+// Distances ignore the fifty move rule
+
+namespace lc::tablebase {
+    // Largest sets 'table_names' lists and 'generate' supports
+    constexpr size_t MAX_PIECES = 4;
+
+    enum class Wdl : uint8_t { Loss, Draw, Win };
+
+    struct ProbeResult {
+        Wdl wdl;
+        // Plies to mate with best play of both sides, 0 for draws
+        int dtm;
+    };
+
+    // Position index of a set
+    struct Layout {
+        // White king, black king, then the other white and black
+        // pieces, strongest first
+        std::vector<Piece> pieces;
+        bool               pawns = false;
+        // Flag for a capturable pawn, only sets with pawns of both
+        // colors can have one
+        bool               en_passant = false;
+        // Positions, reachable or not
+        uint64_t           size = 0;
+    };
+
+    // Layout of a set name ("KQvKR"), std::nullopt if it isn't one
+    // with white the stronger side and at most 'MAX_PIECES' pieces
+    std::optional<Layout> layout(const std::string& name);
+    // Name of the set of 'board' ("KRvKQ" is "KQvKR"), without
+    // checking it's a supported one
+    std::string material_name(const Board& board);
+    // Sets of 3 to 'pieces' pieces (kings included), each one after
+    // the sets its captures and promotions lead to
+    std::vector<std::string> table_names(size_t pieces = MAX_PIECES);
+
+    // Read only tables, probed in place from memory maps
+    class Tablebases {
+        private:
+        struct Table {
+            MappedFile     file;
+            Layout         layout;
+            const uint8_t* wdl;
+            const uint8_t* dtm;
+        };
+
+        // By material key
+        std::unordered_map<uint32_t,Table> tables;
+        size_t                             largest;
+
+        public:
+        Tablebases();
+
+        // Loads the table file of every set of 'table_names' found in
+        // 'directory', returns how many
+        size_t open(const std::string& directory);
+        // False if the file can't be mapped or isn't a table
+        bool add(const std::string& path);
+        void close();
+
+        size_t size() const { return tables.size(); }
+        // Pieces of the largest loaded set, kings included
+        size_t max_pieces() const { return largest; }
+
+        // Constant time, std::nullopt if the set isn't loaded or
+        // castling is still possible
+        std::optional<Wdl> probe_wdl(const ChessGame& game) const;
+        std::optional<ProbeResult> probe(const ChessGame& game) const;
+        // Same for a position without castling rights, 'us' to move
+        std::optional<ProbeResult> probe(const Board& board, Color us, Square en_passant) const;
+
+        private:
+        // Table of the set of 'board' and the position index in it
+        std::pair<const Table*,uint64_t> find(const Board& board, Color us, Square en_passant) const;
+    };
+
+    struct GenerateStats {
+        uint64_t positions = 0;
+        // Reachable positions by outcome, for the side to move
+        uint64_t wins = 0;
+        uint64_t draws = 0;
+        uint64_t losses = 0;
+        // Plies
+        int      longest_mate = 0;
+    };
+
+    // Solves the set 'name' by retrograde analysis spread over 'pool'
+    // and writes its table to 'path'. Sets reached by captures and
+    // promotions must be loaded in 'tables'. std::nullopt if 'name'
+    // isn't a supported set, a table is missing or the file can't be
+    // written
+    std::optional<GenerateStats> generate(
+        const std::string& name,
+        const Tablebases& tables,
+        ThreadPool& pool,
+        const std::string& path);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lc {
+    // Persistent workers for work repeated often enough that spawning
+    // threads each time would cost more than the work itself
+    class ThreadPool {
+        private:
+        std::vector<std::thread>           workers;
+        std::mutex                         mutex;
+        std::condition_variable            start_cv;
+        std::condition_variable            done_cv;
+        // Current job, guarded by 'mutex'
+        const std::function<void(size_t)>* job;
+        size_t                             task_count;
+        // Bumped for every job, wakes the workers
+        uint64_t                           generation;
+        // Workers still on the current job
+        size_t                             active;
+        bool                               quit;
+        std::atomic<size_t>                next_task;
+
+        public:
+        // 'threads' counts the calling thread, 0 for one per hardware
+        // thread
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return unsigned(workers.size()) + 1; }
+
+        // Calls 'job(i)' for every i in [0, tasks) over the workers and
+        // the calling thread, returns once every task is done. Not
+        // reentrant, a single job runs at a time
+        void run(size_t tasks, const std::function<void(size_t)>& job);
+
+        private:
+        void work();
+    };
+}
\ No newline at end of file
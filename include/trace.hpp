@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "packed_move.hpp"
+
+// Opt-in instrumentation, built with 'LC_TRACE' defined (make
+// TRACE=1). Otherwise every hook compiles to nothing and the
+// functions below only report zeros
+
+#ifdef LC_TRACE
+    #define LC_TRACE_ENABLED 1
+    // Adds 'n' to a counter of the calling thread (i.e
+    // LC_TRACE_COUNT(applied, 1))
+    #define LC_TRACE_COUNT(counter, n) \
+        ::lc::trace::detail::add(::lc::trace::detail::local().counter, (n))
+    // Sends an event to the installed sink, if any
+    #define LC_TRACE_EVENT(...) \
+        ::lc::trace::detail::emit(::lc::trace::Event{__VA_ARGS__})
+#else
+    #define LC_TRACE_ENABLED 0
+    #define LC_TRACE_COUNT(counter, n) ((void)0)
+    #define LC_TRACE_EVENT(...) ((void)0)
+#endif
+
+namespace lc::trace {
+    struct Counters {
+        // Legal moves generated, indexed by piece kind
+        uint64_t generated[7] = {};
+        // Moves made, null moves excluded
+        uint64_t applied = 0;
+        // 'ChessGame::move' rejections, indexed by 'MoveError'
+        uint64_t rejected[MOVE_ERROR_COUNT] = {};
+    };
+
+    enum class EventType : uint8_t {
+        MoveApplied,
+        MoveRejected
+    };
+
+    struct Event {
+        EventType  type;
+        // Rejected moves keep only their squares
+        PackedMove move;
+        MoveError  error = MoveError::None;
+    };
+
+    // Called on the thread producing the event, must be thread safe
+    // if the library is used from several threads
+    using Sink = void(*)(const Event&);
+
+    // Sums of every thread, including finished ones
+    Counters counters();
+    // Updates racing with a reset may survive it
+    void reset_counters();
+    // nullptr removes the sink
+    void set_sink(Sink);
+
+    namespace detail {
+        // Counters of a single thread, only written by it. Relaxed
+        // loads and stores keep reads from other threads defined
+        // without any locked instruction on the hot path
+        struct LocalCounters {
+            std::atomic<uint64_t> generated[7] = {};
+            std::atomic<uint64_t> applied = 0;
+            std::atomic<uint64_t> rejected[MOVE_ERROR_COUNT] = {};
+        };
+
+        LocalCounters& local();
+        void emit(const Event&);
+
+        inline void add(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "packed_move.hpp"
+
+// Bound of a stored score
+#define BOUND_NONE  0
+#define BOUND_UPPER 1
+#define BOUND_LOWER 2
+#define BOUND_EXACT (BOUND_UPPER | BOUND_LOWER)
+
+namespace lc {
+    struct TTData {
+        PackedMove move;
+        int16_t    score;
+        int16_t    eval;
+        uint8_t    depth;
+        uint8_t    bound;
+    };
+
+    // Fixed size hash table of search results, shared by any number
+    // of threads without locks. Each entry stores 'key ^ data' next
+    // to 'data', a torn write (key and data from different stores)
+    // fails the xor check and reads as a miss.
+    class TranspositionTable {
+        public:
+        static constexpr size_t ENTRIES_PER_BUCKET = 4;
+
+        private:
+        struct Entry {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+        // One bucket per cache line
+        struct alignas(64) Bucket {
+            Entry entries[ENTRIES_PER_BUCKET];
+        };
+        static_assert(sizeof(Bucket) == 64);
+
+        Bucket*  buckets;
+        size_t   bucket_mask;
+        // Memory comes from mmap (huge pages), malloc otherwise
+        bool     mapped;
+        // Incremented every new search, older entries get replaced first
+        uint8_t  age;
+
+        public:
+        // Size is rounded down to a power of two number of buckets.
+        // With 'use_huge_pages' the table is backed by huge pages if
+        // the system allows it, regular pages otherwise
+        explicit TranspositionTable(size_t size_mb = 16, bool use_huge_pages = false);
+        ~TranspositionTable();
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        // Reallocates, previous entries are lost
+        void resize(size_t size_mb, bool use_huge_pages = false);
+        void clear();
+        // Called once per search, before any store
+        void new_search() { age = (age + 1) & 0x3f; }
+
+        bool probe(uint64_t key, TTData& out) const;
+        void store(uint64_t key, const TTData& data);
+        // Brings the bucket of 'key' to cache ahead of a probe
+        void prefetch(uint64_t key) const;
+
+        size_t size_bytes() const { return (bucket_mask + 1) * sizeof(Bucket); }
+        // Permille of used entries of the current search, over a sample
+        int hashfull() const;
+
+        private:
+        Bucket& bucket(uint64_t key) const { return buckets[key & bucket_mask]; }
+        void allocate(size_t size_mb, bool use_huge_pages);
+        void deallocate();
+    };
+}
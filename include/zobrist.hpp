@@ -0,0 +1,90 @@
+#pragma once
+
+#include "piece_moves.hpp"
+
+// Zobrist keys, generated at compile time:
+//   - 'piece_keys' indexed by raw piece (kind | color) and square,
+//     0 for empty squares
+//   - 'castling_keys' indexed by the castling bits of a game state,
+//     states with the same castling rights share the same key
+//   - 'en_passant_keys' indexed by en passant file
+//   - 'turn_key' toggled when black is to move
+
+namespace lc::zobrist {
+    constexpr uint64_t piece_key(const Piece& piece, Square sq);
+    constexpr uint64_t en_passant_key(Square en_passant);
+
+    // Hash of the pieces only, computed over every square
+    constexpr uint64_t board_hash(const Board& board);
+}
+
+/////////////// Implementation ///////////////
+
+namespace lc::zobrist {
+    namespace detail {
+        // splitmix64, fixed seed so keys are equal across builds
+        constexpr uint64_t next_key(uint64_t& seed) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        struct Keys {
+            std::array<std::array<uint64_t,64>,16> pieces = {};
+            std::array<uint64_t,64> castling = {};
+            std::array<uint64_t,8> en_passant = {};
+            uint64_t turn = 0;
+        };
+
+        constexpr Keys make_keys() {
+            Keys keys;
+            uint64_t seed = 0x6c69676874636865ULL;
+            for(uint8_t color : { WHITE, BLACK })
+                for(uint8_t kind = PAWN; kind <= KING; ++kind)
+                    for(auto& key : keys.pieces[kind | color])
+                        key = next_key(seed);
+            // One key per castling right, a right is available while
+            // neither the king nor that rook have moved
+            const uint8_t right_bits[4] = {
+                WHITE_KING_MOVED_BIT | WHITE_KINGSIDE_ROOK_MOVED_BIT,
+                WHITE_KING_MOVED_BIT | WHITE_QUEENSIDE_ROOK_MOVED_BIT,
+                BLACK_KING_MOVED_BIT | BLACK_KINGSIDE_ROOK_MOVED_BIT,
+                BLACK_KING_MOVED_BIT | BLACK_QUEENSIDE_ROOK_MOVED_BIT
+            };
+            uint64_t right_keys[4];
+            for(auto& key : right_keys)
+                key = next_key(seed);
+            for(uint8_t bits = 0; bits <= CASTLING_STATE_MASK; ++bits)
+                for(uint8_t i = 0; i < 4; ++i)
+                    if(!(bits & right_bits[i]))
+                        keys.castling[bits] ^= right_keys[i];
+            for(auto& key : keys.en_passant)
+                key = next_key(seed);
+            keys.turn = next_key(seed);
+            return keys;
+        }
+
+        inline constexpr Keys keys = make_keys();
+    }
+
+    inline constexpr const std::array<std::array<uint64_t,64>,16>& piece_keys = detail::keys.pieces;
+    inline constexpr const std::array<uint64_t,64>& castling_keys = detail::keys.castling;
+    inline constexpr const std::array<uint64_t,8>& en_passant_keys = detail::keys.en_passant;
+    inline constexpr uint64_t turn_key = detail::keys.turn;
+
+    constexpr uint64_t piece_key(const Piece& piece, Square sq) {
+        return piece_keys[piece.raw()][sq];
+    }
+
+    constexpr uint64_t en_passant_key(Square en_passant) {
+        return en_passant == NO_SQUARE ? 0 : en_passant_keys[en_passant % 8];
+    }
+
+    constexpr uint64_t board_hash(const Board& board) {
+        uint64_t hash = 0;
+        for(Square sq = 0; sq < 64; ++sq)
+            hash ^= piece_key(board.at(sq), sq);
+        return hash;
+    }
+}
@@ -0,0 +1,232 @@
+#include "archive.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+static_assert(std::endian::native == std::endian::little, "Archives are little endian");
+
+namespace {
+    constexpr char ARCHIVE_MAGIC[8] = { 'L', 'C', 'A', 'R', 'C', 'H', 'I', 'V' };
+    constexpr uint32_t ARCHIVE_VERSION = 1;
+
+    constexpr uint64_t align8(uint64_t offset) {
+        return (offset + 7) & ~uint64_t(7);
+    }
+
+    void write_padding(std::ofstream& file) {
+        static const char zeros[8] = {};
+        const auto offset = uint64_t(file.tellp());
+        file.write(zeros, std::streamsize(align8(offset) - offset));
+    }
+}
+
+namespace lc {
+    ArchiveWriter::ArchiveWriter()
+        : move_count(0) {}
+
+    ArchiveWriter::ArchiveWriter(const std::string& path)
+        : ArchiveWriter()
+    {
+        open(path);
+    }
+
+    ArchiveWriter::~ArchiveWriter() {
+        if(is_open())
+            close();
+    }
+
+    bool ArchiveWriter::open(const std::string& path) {
+        if(is_open())
+            close();
+        entries.clear();
+        starts.clear();
+        move_count = 0;
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if(!file)
+            return false;
+        // Header is written for real by 'close'
+        const ArchiveHeader header = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return bool(file);
+    }
+
+    bool ArchiveWriter::add_game(
+        std::span<const PackedMove> moves,
+        uint8_t result,
+        const BoardState* start)
+    {
+        if(!is_open())
+            return false;
+        // Null moves can't be replayed
+        if((start && !is_valid_state(*start))
+            || std::any_of(moves.begin(), moves.end(), [](PackedMove m) { return m.is_none(); }))
+        {
+            return false;
+        }
+        ArchiveEntry entry = {};
+        entry.first_move = move_count;
+        entry.move_count = uint32_t(moves.size());
+        entry.result = result;
+        if(start) {
+            entry.flags |= ARCHIVE_CUSTOM_START;
+            // Zeroed padding, so files are reproducible
+            ArchiveStart archive_start;
+            std::memset(&archive_start, 0, sizeof(archive_start));
+            archive_start.game = entries.size();
+            archive_start.board_state = *start;
+            starts.push_back(archive_start);
+        }
+        entries.push_back(entry);
+        file.write(reinterpret_cast<const char*>(moves.data()), std::streamsize(moves.size_bytes()));
+        move_count += moves.size();
+        return bool(file);
+    }
+
+    bool ArchiveWriter::add_game(const ChessGame& game, uint8_t result) {
+        // Starting position is found by taking back every move
+        auto start = game;
+        while(start.undo()) {}
+        const auto board_state = start.board_state();
+        const bool standard = board_state.board_data == Board::standard().board_data
+            && board_state.state == 0
+            && board_state.en_passant == NO_SQUARE
+            && board_state.halfmove_clock == 0
+            && board_state.fullmove_number == 1;
+        return add_game(game.history(), result, standard ? nullptr : &board_state);
+    }
+
+    bool ArchiveWriter::close() {
+        if(!is_open())
+            return false;
+
+        ArchiveHeader header = {};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.version = ARCHIVE_VERSION;
+        header.game_count = entries.size();
+        header.move_count = move_count;
+        header.start_count = starts.size();
+        header.moves_offset = sizeof(ArchiveHeader);
+
+        write_padding(file);
+        header.index_offset = uint64_t(file.tellp());
+        file.write(reinterpret_cast<const char*>(entries.data()),
+            std::streamsize(entries.size() * sizeof(ArchiveEntry)));
+        header.starts_offset = uint64_t(file.tellp());
+        file.write(reinterpret_cast<const char*>(starts.data()),
+            std::streamsize(starts.size() * sizeof(ArchiveStart)));
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        const bool written = bool(file);
+        file.close();
+        entries = {};
+        starts = {};
+        return written && !file.fail();
+    }
+
+    ArchiveReader::ArchiveReader()
+        : entries(nullptr)
+        , moves(nullptr)
+        , starts(nullptr)
+        , game_count(0)
+        , move_count(0)
+        , start_count(0) {}
+
+    ArchiveReader::ArchiveReader(const std::string& path)
+        : ArchiveReader()
+    {
+        open(path);
+    }
+
+    bool ArchiveReader::open(const std::string& path) {
+        close();
+        if(!file.open(path))
+            return false;
+
+        // Every section must lie inside the file
+        ArchiveHeader header;
+        const auto size = file.size();
+        if(size < sizeof(header)) {
+            close();
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        const auto fits = [&](uint64_t offset, uint64_t count, uint64_t item_size) {
+            return offset % 8 == 0
+                && offset <= size
+                && count <= (size - offset) / item_size;
+        };
+        if(std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0
+            || header.version != ARCHIVE_VERSION
+            || !fits(header.moves_offset, header.move_count, sizeof(PackedMove))
+            || !fits(header.index_offset, header.game_count, sizeof(ArchiveEntry))
+            || !fits(header.starts_offset, header.start_count, sizeof(ArchiveStart)))
+        {
+            close();
+            return false;
+        }
+
+        entries = reinterpret_cast<const ArchiveEntry*>(file.data() + header.index_offset);
+        moves = reinterpret_cast<const PackedMove*>(file.data() + header.moves_offset);
+        starts = reinterpret_cast<const ArchiveStart*>(file.data() + header.starts_offset);
+        game_count = header.game_count;
+        move_count = header.move_count;
+        start_count = header.start_count;
+        return true;
+    }
+
+    void ArchiveReader::close() {
+        file.close();
+        entries = nullptr;
+        moves = nullptr;
+        starts = nullptr;
+        game_count = 0;
+        move_count = 0;
+        start_count = 0;
+    }
+
+    ArchiveGame ArchiveReader::operator[](size_t game) const {
+        const auto& entry = entries[game];
+        // Games moves are checked lazily, opening doesn't scan the
+        // whole index. Games out of the moves section read as empty
+        std::span<const PackedMove> game_moves;
+        if(entry.first_move <= move_count
+            && entry.move_count <= move_count - entry.first_move)
+        {
+            game_moves = { moves + entry.first_move, entry.move_count };
+        }
+        const BoardState* start = nullptr;
+        if(entry.flags & ARCHIVE_CUSTOM_START) {
+            const auto it = std::lower_bound(starts, starts + start_count, game,
+                [](const ArchiveStart& s, size_t g) { return s.game < g; });
+            if(it != starts + start_count && it->game == game)
+                start = &it->board_state;
+        }
+        return { game_moves, entry.result, start };
+    }
+
+    std::optional<ChessGame> start_game(const ArchiveGame& archived) {
+        if(!archived.start)
+            return ChessGame(Board::standard());
+        if(!is_valid_state(*archived.start))
+            return std::nullopt;
+        return ChessGame(*archived.start);
+    }
+
+    std::optional<ChessGame> replay(const ArchiveGame& archived, size_t plies) {
+        auto game = start_game(archived);
+        if(!game.has_value())
+            return std::nullopt;
+        plies = std::min(plies, archived.moves.size());
+        game->reserve(plies);
+        for(size_t i = 0; i < plies; ++i) {
+            const auto move = find_legal_move(game->board, game->turn(),
+                game->castling_state(), game->en_passant_square(), archived.moves[i]);
+            if(!move.has_value())
+                return std::nullopt;
+            game->make_move(*move);
+        }
+        return game;
+    }
+}
\ No newline at end of file
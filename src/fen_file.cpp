@@ -0,0 +1,121 @@
+#include "fen_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "mapped_file.hpp"
+#include "notation.hpp"
+
+namespace {
+    // Below this size per thread, spawning threads costs more than
+    // parsing
+    constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    // Lines of a chunk, counted by their starts
+    size_t count_lines(std::string_view chunk) {
+        if(chunk.empty())
+            return 0;
+        size_t lines = 0;
+        const char* it = chunk.data();
+        const char* end = chunk.data() + chunk.size();
+        while((it = static_cast<const char*>(std::memchr(it, '\n', size_t(end - it))))) {
+            ++lines;
+            if(++it == end)
+                return lines;
+        }
+        // Last line without a line break
+        return lines + 1;
+    }
+
+    template<typename F>
+    void for_each_line(std::string_view chunk, F&& f) {
+        while(!chunk.empty()) {
+            const auto end = std::min(chunk.find('\n'), chunk.size());
+            auto line = chunk.substr(0, end);
+            chunk.remove_prefix(std::min(end + 1, chunk.size()));
+            if(!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            f(line);
+        }
+    }
+
+    // Splits 'text' in up to 'count' chunks, each ending at a line
+    // break
+    std::vector<std::string_view> split_lines(std::string_view text, size_t count) {
+        std::vector<std::string_view> chunks;
+        size_t begin = 0;
+        for(size_t i = 1; i <= count && begin < text.size(); ++i) {
+            size_t end = text.size() * i / count;
+            if(end < begin)
+                end = begin;
+            end = std::min(text.find('\n', end), text.size());
+            if(end < text.size())
+                ++end;
+            chunks.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+        return chunks;
+    }
+}
+
+namespace lc {
+    FenBatch parse_fen_lines(std::string_view text, unsigned threads) {
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = unsigned(std::clamp<size_t>(text.size() / MIN_CHUNK_SIZE, 1, threads));
+
+        const auto chunks = split_lines(text, threads);
+        const auto run = [&](auto&& job) {
+            std::vector<std::thread> workers;
+            for(size_t i = 1; i < chunks.size(); ++i)
+                workers.emplace_back(job, i);
+            if(!chunks.empty())
+                job(0);
+            for(auto& worker : workers)
+                worker.join();
+        };
+
+        // Lines are counted first, so every chunk parses straight
+        // into its own slice of a single array
+        std::vector<size_t> offsets(chunks.size() + 1, 0);
+        run([&](size_t i) { offsets[i + 1] = count_lines(chunks[i]); });
+        for(size_t i = 0; i < chunks.size(); ++i)
+            offsets[i + 1] += offsets[i];
+
+        FenBatch batch;
+        batch.positions.resize(offsets.back());
+        std::vector<size_t> valid(chunks.size(), 0);
+        std::vector<size_t> invalid(chunks.size(), 0);
+        run([&](size_t i) {
+            auto* out = batch.positions.data() + offsets[i];
+            for_each_line(chunks[i], [&](std::string_view line) {
+                if(line.find_first_not_of(" \t") == std::string_view::npos)
+                    return;
+                if(const auto board_state = state_from_fen(line))
+                    out[valid[i]++] = *board_state;
+                else
+                    ++invalid[i];
+            });
+        });
+
+        // Slices are compacted over the lines that didn't parse
+        size_t size = 0;
+        for(size_t i = 0; i < chunks.size(); ++i) {
+            const auto* slice = batch.positions.data() + offsets[i];
+            if(size != offsets[i])
+                std::memmove(batch.positions.data() + size, slice, valid[i] * sizeof(BoardState));
+            size += valid[i];
+            batch.invalid_lines += invalid[i];
+        }
+        batch.positions.resize(size);
+        return batch;
+    }
+
+    std::optional<FenBatch> load_fen_file(const std::string& path, unsigned threads) {
+        const MappedFile file(path);
+        if(!file.is_open())
+            return std::nullopt;
+        return parse_fen_lines(file.view(), threads);
+    }
+}
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "game.hpp"
 
+#include <algorithm>
+
+#include "evaluation.hpp"
 #include "piece_moves.hpp"
+#include "trace.hpp"
+#include "zobrist.hpp"
 
 std::optional<lc::Move> get_move(
-    const std::vector<lc::Move>& moves,
+    const lc::MoveList& moves,
     const lc::Position& to)
 {
     for(const auto& move : moves) {
@@ -14,219 +19,498 @@ std::optional<lc::Move> get_move(
     return std::nullopt;
 }
 
-void apply_move(lc::Board& board, lc::Move& move, uint8_t& state) {
+// Rejection of 'ChessGame::move', traced when enabled
+lc::MoveError reject(
+    [[maybe_unused]] const lc::Position& from,
+    [[maybe_unused]] const lc::Position& to,
+    lc::MoveError error)
+{
+    LC_TRACE_COUNT(rejected[size_t(error)], 1);
+    LC_TRACE_EVENT(lc::trace::EventType::MoveRejected,
+        lc::PackedMove(lc::square_of(from), lc::square_of(to)), error);
+    return error;
+}
+
+// 'ChessGame::cached' bit of 'checkers_cache', attack maps use bits 0
+// and 1 by color index
+constexpr uint8_t CHECKERS_CACHED = 0b100;
+
+// a8 is a light square
+constexpr lc::Bitboard LIGHT_SQUARES_BB = 0xaa55aa55aa55aa55;
+
+// Castling bit lost when a move starts or ends in a rook corner
+uint8_t rook_moved_bits(const lc::Position& pos) {
+    if(pos == lc::Position{0,7}) return WHITE_QUEENSIDE_ROOK_MOVED_BIT;
+    if(pos == lc::Position{7,7}) return WHITE_KINGSIDE_ROOK_MOVED_BIT;
+    if(pos == lc::Position{0,0}) return BLACK_QUEENSIDE_ROOK_MOVED_BIT;
+    if(pos == lc::Position{7,0}) return BLACK_KINGSIDE_ROOK_MOVED_BIT;
+    return 0;
+}
+
+void apply_move(
+    lc::Board& board,
+    const lc::Move& move,
+    uint8_t& state,
+    lc::Square& en_passant,
+    uint64_t& hash,
+    lc::eval::Score& psq)
+{
+    // Sets a piece keeping the hash and the evaluation in sync
+    const auto put = [&](const lc::Position& pos, const lc::Piece& piece) {
+        const auto sq = lc::square_of(pos);
+        const auto old_piece = board.at(sq);
+        hash ^= lc::zobrist::piece_key(old_piece, sq) ^ lc::zobrist::piece_key(piece, sq);
+        psq -= lc::eval::psq_score(old_piece, sq);
+        psq += lc::eval::psq_score(piece, sq);
+        board.set(pos, piece);
+    };
+
+    hash ^= lc::zobrist::castling_keys[state & CASTLING_STATE_MASK]
+        ^ lc::zobrist::en_passant_key(en_passant);
+    en_passant = lc::NO_SQUARE;
     move.visit(
         [&](lc::Move::Normal arg) {
             const auto from_piece = board.at(move.from());
-            board.set(move.to(), from_piece);
-            board.set(move.from(), NONE);
+            put(move.to(), from_piece);
+            put(move.from(), NONE);
 
             // Set states
             if(from_piece.raw() == (KING | WHITE)) [[unlikely]] 
                 state |= WHITE_KING_MOVED_BIT;
             if(from_piece.raw() == (KING | BLACK)) [[unlikely]] 
                 state |= BLACK_KING_MOVED_BIT;
-            if(from_piece.raw() == (ROOK | WHITE)) [[unlikely]] {
-                if(move.from() == lc::Position{0,7}) {
-                    state |= WHITE_KINGSIDE_ROOK_MOVED_BIT;
-                }
-                else if(move.from() == lc::Position{7,7}) {
-                    state |= WHITE_QUEENSIDE_ROOK_MOVED_BIT;
-                }
-            }
-            if(from_piece.raw() == (ROOK | BLACK)) [[unlikely]] {
-                if(move.from() == lc::Position{0,0}) {
-                    state |= BLACK_KINGSIDE_ROOK_MOVED_BIT;
-                }
-                else if(move.from() == lc::Position{7,0}) {
-                    state |= BLACK_QUEENSIDE_ROOK_MOVED_BIT;
+            // Moving a rook from, or capturing one in, its corner
+            state |= rook_moved_bits(move.from()) | rook_moved_bits(move.to());
+
+            // Pawn double move can be captured en passant in the
+            // next turn, only if an opponent pawn is next to it
+            if(from_piece.kind() == PAWN
+                && std::abs(move.from()[1] - move.to()[1]) == 2) [[unlikely]]
+            {
+                const auto skipped = lc::Position{
+                    move.from()[0],
+                    uint8_t((move.from()[1] + move.to()[1]) / 2)
+                };
+                const auto sq = lc::square_of(skipped);
+                const auto opponent = from_piece.color() ^ BLACK;
+                if(lc::pawn_attacks[lc::color_index(from_piece.color())][sq]
+                    & board.pieces(opponent, PAWN))
+                {
+                    en_passant = sq;
                 }
             }
-                        
-            fmt::print("Normal\n");
         },
         [&](lc::Move::Promotion arg) {
-            board.set(move.to(), arg.to);
-            board.set(move.from(), NONE);
-            fmt::print("Promotion\n");
+            put(move.to(), arg.to);
+            put(move.from(), NONE);
+            state |= rook_moved_bits(move.to());
         },
         [&](lc::Move::Castling arg) {
-            board.set(move.to(), board.at(move.from()));
-            board.set(move.from(), NONE);
+            put(move.to(), board.at(move.from()));
+            put(move.from(), NONE);
 
             // White kingside castling
             if(move.to() == lc::Position{6,7}) {
                 const lc::Position rook_pos = {7,7};
-                board.set(lc::Position{5,7}, board.at(rook_pos));
-                board.set(rook_pos, NONE);
+                put(lc::Position{5,7}, board.at(rook_pos));
+                put(rook_pos, NONE);
                 state |= (WHITE_KINGSIDE_ROOK_MOVED_BIT | WHITE_KING_MOVED_BIT);
             }
             // White queenside castling
             else if(move.to() == lc::Position{2,7}) {
                 const lc::Position rook_pos = {0,7};
-                board.set(lc::Position{3,7}, board.at(rook_pos));
-                board.set(rook_pos, NONE);
+                put(lc::Position{3,7}, board.at(rook_pos));
+                put(rook_pos, NONE);
                 state |= (WHITE_QUEENSIDE_ROOK_MOVED_BIT | WHITE_KING_MOVED_BIT);
             }
             // Black kingside castling
             else if(move.to() == lc::Position{6,0}) {
                 const lc::Position rook_pos = {7,0};
-                board.set(lc::Position{5,0}, board.at(rook_pos));
-                board.set(rook_pos, NONE);
+                put(lc::Position{5,0}, board.at(rook_pos));
+                put(rook_pos, NONE);
                 state |= (BLACK_KINGSIDE_ROOK_MOVED_BIT | BLACK_KING_MOVED_BIT);
             }
             // Black queenside castling
             else if(move.to() == lc::Position{2,0}) {
                 const lc::Position rook_pos = {0,0};
-                board.set(lc::Position{3,0}, board.at(rook_pos));
-                board.set(rook_pos, NONE);
+                put(lc::Position{3,0}, board.at(rook_pos));
+                put(rook_pos, NONE);
                 state |= (BLACK_QUEENSIDE_ROOK_MOVED_BIT | BLACK_KING_MOVED_BIT);
             }
-            fmt::print("Castling\n");
         },
         [&](lc::Move::EnPassant arg) {
-            board.set(move.to(), board.at(move.from()));
-            board.set(move.from(), NONE);
-            board.set({move.to()[0],move.from()[1]}, NONE);
-            fmt::print("En Passant\n");
+            put(move.to(), board.at(move.from()));
+            put(move.from(), NONE);
+            put({move.to()[0],move.from()[1]}, NONE);
         }
     );
+    hash ^= lc::zobrist::castling_keys[state & CASTLING_STATE_MASK]
+        ^ lc::zobrist::en_passant_key(en_passant);
+}
+
+// Reverts the board changes of 'apply_move', state and en passant
+// square are restored from the undo record by the caller
+void undo_move(
+    lc::Board& board,
+    const lc::PackedMove& move,
+    const lc::Piece& captured)
+{
+    const auto moved_piece = board.at(move.to());
+    if(move.is_promotion()) [[unlikely]] {
+        board.set(move.from(), lc::pawn(moved_piece.color()));
+        board.set(move.to(), captured);
+    }
+    else if(move.is_castling()) [[unlikely]] {
+        board.set(move.from(), moved_piece);
+        board.set(move.to(), NONE);
+
+        const uint8_t row = move.to()[1];
+        // Kingside castling
+        if(move.to()[0] == 6) {
+            board.set(lc::Position{7,row}, board.at(lc::Position{5,row}));
+            board.set(lc::Position{5,row}, NONE);
+        }
+        // Queenside castling
+        else {
+            board.set(lc::Position{0,row}, board.at(lc::Position{3,row}));
+            board.set(lc::Position{3,row}, NONE);
+        }
+    }
+    else if(move.is_en_passant()) [[unlikely]] {
+        board.set(move.from(), moved_piece);
+        board.set(move.to(), NONE);
+        board.set({move.to()[0],move.from()[1]}, lc::pawn(moved_piece.color() ^ BLACK));
+    }
+    else {
+        board.set(move.from(), moved_piece);
+        board.set(move.to(), captured);
+    }
 }
 
 namespace lc {
     ChessGame::ChessGame(const Board& _board, bool _free_game)
-        : board(_board)
-        , free_game(_free_game)
+        : free_game(_free_game)
+        , state(0)
+        , en_passant(NO_SQUARE)
+        , halfmove_clock(0)
+        , game_ply(0)
+        , cached(0)
+        , board(_board)
+    {
+        // Average 2000-2800 elo games duration
+        move_history.reserve(40);
+        undo_history.reserve(40);
+        hash_key = compute_hash();
+        psq = eval::board_score(board);
+    }
+
+    ChessGame::ChessGame(const BoardState& _board_state, bool _free_game)
+        : free_game(_free_game)
+        , state(_board_state.state)
+        , en_passant(_board_state.en_passant)
+        , halfmove_clock(_board_state.halfmove_clock)
+        , game_ply(uint16_t(
+            (std::max<uint16_t>(_board_state.fullmove_number, 1) - 1) * 2
+            + ((_board_state.state & TURN_COLOR_BIT) ? 1 : 0)))
+        , cached(0)
+        , board(_board_state.board_data)
     {
         // Average 2000-2800 elo games duration
         move_history.reserve(40);
+        undo_history.reserve(40);
+        hash_key = compute_hash();
+        psq = eval::board_score(board);
     }
 
     ChessGame::ChessGame(Board&& _board, bool _free_game)
-        : board(std::move(_board))
-        , free_game(_free_game)
+        : free_game(_free_game)
+        , state(0)
+        , en_passant(NO_SQUARE)
+        , halfmove_clock(0)
+        , game_ply(0)
+        , cached(0)
+        , board(std::move(_board))
     {
         // Average 2000-2800 elo games duration
         move_history.reserve(40);
+        undo_history.reserve(40);
+        hash_key = compute_hash();
+        psq = eval::board_score(board);
     }
 
-    bool ChessGame::move(const Position& from, const Position& to) {
-        std::optional<Move> move_opt = std::nullopt;
+    MoveError ChessGame::move(const Position& from, const Position& to) {
         const Piece piece = board.at(from);
 
         // If 'state & TURN_COLOR_BIT' is true then 
         // its white pieces turn otherwise black
         // pieces turn
+        if(piece.kind() == NONE)
+            return reject(from, to, MoveError::NoPiece);
         if(state & TURN_COLOR_BIT) {
-            if(piece.is_white()) {
-                fmt::print("Not your turn\n");
-                return false;
-            }
+            if(piece.is_white())
+                return reject(from, to, MoveError::NotYourTurn);
         }
         else {
-            if(piece.is_black()) {
-                fmt::print("Not your turn\n");
-                return false;
-            }
-        }
-        
-        // // More compact way to do the if statements
-        // // not necessarily more efficient
-        // if(!(((state & TURN_COLOR_BIT) >> 6) ^ piece.color()))
-        //     return false;
-
-        // In case piece is None or move is invalid
-        switch (piece.kind()) {
-            case PAWN: {
-                // Retrieve last move, needed to check for~
-                // en passant move possibility
-                auto last_move = move_history.empty()
-                    	? std::nullopt
-                        : static_cast<std::optional<Move>>(move_history.back());
-                // Retrieve pawn possible moveset
-                auto possible_moves = pawn_moves(board, piece, from, last_move);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
-            case KNIGHT: {
-                // Retrieve knight possible moveset
-                auto possible_moves = knight_moves(board, piece, from);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
-            case BISHOP: {
-                // Retrieve bishop possible moveset
-                auto possible_moves = bishop_moves(board, piece, from);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
-            case ROOK: {
-                // Retrieve rook possible moveset
-                auto possible_moves = rook_moves(board, piece, from);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
-            case QUEEN: {
-                // Retrieve queen possible moveset
-                auto possible_moves = queen_moves(board, piece, from);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
-            case KING: {
-                // Retrieve king possible moveset
-                auto possible_moves = king_moves(board, piece, from, state);
-                move_opt = get_move(possible_moves, to);
-                break;
-            }
+            if(piece.is_black())
+                return reject(from, to, MoveError::NotYourTurn);
         }
 
-        if(move_opt.has_value()) {
-            auto move = *move_opt;
-            // Apply move if exists, to board
-            apply_move(board, move, state);
-            // Add move to move history
-            move_history.push_back(move);
-            // Flip turn color
-            if(!free_game)
-                state ^= TURN_COLOR_BIT;
+        // Moves leaving the own king in check are not in the moveset
+        MoveList possible_moves;
+        piece_moveset(from, possible_moves);
+        const auto move_opt = get_move(possible_moves, to);
+        if(!move_opt.has_value())
+            return reject(from, to, MoveError::InvalidMove);
+        // Apply move if exists, to board
+        make_move(*move_opt);
+        return MoveError::None;
+    }
+
+    void ChessGame::make_move(const Move& move) {
+        // Save what 'apply_move' overwrites, en passant captures are
+        // restored from the move flag
+        const auto captured = board.at(move.to());
+        undo_history.push_back({captured, state, en_passant, halfmove_clock, psq, hash_key});
+        cached = 0;
+        // Captures and pawn moves are irreversible
+        const auto packed = PackedMove(move);
+        if(captured.kind() != NONE
+            || packed.is_en_passant()
+            || board.at(move.from()).kind() == PAWN)
+        {
+            halfmove_clock = 0;
         }
         else {
-            fmt::print("Invalid move\n");
+            ++halfmove_clock;
         }
-        return move_opt.has_value();
+        ++game_ply;
+        apply_move(board, move, state, en_passant, hash_key, psq);
+        // Add move to move history
+        move_history.push_back(packed);
+        LC_TRACE_COUNT(applied, 1);
+        LC_TRACE_EVENT(trace::EventType::MoveApplied, packed);
+        // Flip turn color
+        if(!free_game) {
+            state ^= TURN_COLOR_BIT;
+            hash_key ^= zobrist::turn_key;
+        }
+    }
+
+    void ChessGame::make_null_move() {
+        undo_history.push_back({NONE, state, en_passant, halfmove_clock, psq, hash_key});
+        cached = 0;
+        move_history.push_back(PackedMove::none());
+        ++halfmove_clock;
+        ++game_ply;
+        hash_key ^= zobrist::en_passant_key(en_passant) ^ zobrist::turn_key;
+        en_passant = NO_SQUARE;
+        state ^= TURN_COLOR_BIT;
     }
 
-    std::vector<Move> ChessGame::piece_moveset(const Position& pos) const {
+    void ChessGame::reserve(size_t plies) {
+        move_history.reserve(move_history.size() + plies);
+        undo_history.reserve(undo_history.size() + plies);
+    }
+
+    bool ChessGame::undo() {
+        if(move_history.empty())
+            return false;
+
+        const auto move = move_history.back();
+        const auto record = undo_history.back();
+        move_history.pop_back();
+        undo_history.pop_back();
+
+        // Null moves leave the board untouched
+        if(!move.is_none())
+            undo_move(board, move, record.captured);
+        // Previous state also restores turn color
+        state = record.state;
+        en_passant = record.en_passant;
+        hash_key = record.hash;
+        halfmove_clock = record.halfmove_clock;
+        --game_ply;
+        cached = 0;
+        psq = record.psq;
+        return true;
+    }
+
+    MoveList ChessGame::piece_moveset(const Position& pos) const {
+        MoveList moves;
+        piece_moveset(pos, moves);
+        return moves;
+    }
+
+    void ChessGame::piece_moveset(const Position& pos, MoveList& moves) const {
         const auto piece = board.at(pos);
-        switch (piece.kind())
-        {
-            case PAWN: {
-                auto last_move = move_history.empty()
-                    ? std::nullopt
-                    : static_cast<std::optional<Move>>(move_history.back());
-                return pawn_moves(board, piece, pos, last_move);
-            }
-            case KNIGHT: {
-                // Retrieve knight possible moveset
-                return knight_moves(board, piece, pos);
-            }
-            case BISHOP: {
-                // Retrieve bishop possible moveset
-                return bishop_moves(board, piece, pos);
-            }
-            case ROOK: {
-                // Retrieve rook possible moveset
-                return rook_moves(board, piece, pos);
+        // Legality is decided by the king, a side without one (free
+        // board setups) has no moves
+        if(piece.kind() == NONE || !board.pieces(piece.color(), KING))
+            return;
+        // En passant only belongs to the side to move
+        const Color color = piece.color();
+        generate_legal_moves(board, color, state,
+            color == turn() ? en_passant : NO_SQUARE,
+            moves, MoveGen::All, square_bb(square_of(pos)));
+    }
+
+    uint64_t ChessGame::compute_hash() const {
+        return zobrist::board_hash(board)
+            ^ zobrist::castling_keys[state & CASTLING_STATE_MASK]
+            ^ zobrist::en_passant_key(en_passant)
+            ^ ((state & TURN_COLOR_BIT) ? zobrist::turn_key : 0);
+    }
+
+    BoardState ChessGame::board_state() const {
+        return { board.board_data, state, en_passant, halfmove_clock, fullmove_number() };
+    }
+
+    int ChessGame::evaluate() const {
+        const int score = eval::tapered(psq, eval::phase(board));
+        return turn() == WHITE ? score : -score;
+    }
+
+    Bitboard ChessGame::attacked_squares(Color by) const {
+        const uint8_t bit = 1 << color_index(by);
+        if(!(cached & bit)) {
+            attacked_cache[color_index(by)] = board.attacks(by);
+            cached |= bit;
+        }
+        return attacked_cache[color_index(by)];
+    }
+
+    bool ChessGame::is_square_attacked(const Position& pos, Color by) const {
+        return attacked_squares(by) & square_bb(square_of(pos));
+    }
+
+    Bitboard ChessGame::checkers() const {
+        if(!(cached & CHECKERS_CACHED)) {
+            const auto us = turn();
+            const auto kings = board.pieces(us, KING);
+            checkers_cache = kings
+                ? board.attackers_to(lsb(kings), board.occupancy()) & board.pieces(us ^ BLACK)
+                : 0;
+            cached |= CHECKERS_CACHED;
+        }
+        return checkers_cache;
+    }
+
+    GameStatus ChessGame::status() const {
+        MoveList moves;
+        legal_moves(moves);
+        if(moves.empty())
+            return is_check() ? GameStatus::Checkmate : GameStatus::Stalemate;
+        if(is_fifty_move_rule())
+            return GameStatus::FiftyMoveRule;
+        if(repetitions() >= 2)
+            return GameStatus::ThreefoldRepetition;
+        if(is_insufficient_material())
+            return GameStatus::InsufficientMaterial;
+        return GameStatus::Ongoing;
+    }
+
+    int ChessGame::repetitions() const {
+        // Undo records hold the hash before each move, the window ends
+        // at the last irreversible move, at most 100 plies back
+        const size_t window = std::min<size_t>(halfmove_clock, undo_history.size());
+        const size_t end = undo_history.size();
+        int count = 0;
+        // Same side to move every other ply
+        for(size_t back = 2; back <= window; back += 2) {
+            if(move_history[end - back + 1].is_none() || move_history[end - back].is_none())
+                break;
+            count += undo_history[end - back].hash == hash_key;
+        }
+        return count;
+    }
+
+    bool ChessGame::is_insufficient_material() const {
+        if(board.kind_bb[PAWN] | board.kind_bb[ROOK] | board.kind_bb[QUEEN])
+            return false;
+        const auto knights = board.kind_bb[KNIGHT];
+        const auto bishops = board.kind_bb[BISHOP];
+        if(popcount(knights | bishops) <= 1)
+            return true;
+        // Bishops alone, all of them on light or all on dark squares
+        return !knights
+            && (!(bishops & LIGHT_SQUARES_BB) || !(bishops & ~LIGHT_SQUARES_BB));
+    }
+
+    MoveList ChessGame::legal_moves() const {
+        MoveList moves;
+        legal_moves(moves);
+        return moves;
+    }
+
+    void ChessGame::legal_moves(MoveList& moves) const {
+        // Generation starts from the king
+        if(!board.pieces(turn(), KING))
+            return;
+        generate_legal_moves(board, turn(), state, en_passant, moves);
+    }
+
+    bool is_valid_state(const BoardState& board_state) {
+        for(const auto row : board_state.board_data) {
+            for(size_t x = 0; x < 8; ++x) {
+                const uint8_t piece = (row >> (x*8)) & 0xff;
+                const uint8_t kind = piece & VALUE_MASK;
+                if((piece & ~(COLOR_MASK | VALUE_MASK)) || kind > KING || (piece && kind == NONE))
+                    return false;
             }
-            case QUEEN: {
-                // Retrieve queen possible moveset
-                return queen_moves(board, piece, pos);
+        }
+        if((board_state.state & ~(CASTLING_STATE_MASK | TURN_COLOR_BIT))
+            || board_state.en_passant > NO_SQUARE)
+        {
+            return false;
+        }
+
+        const Board board(board_state.board_data);
+        const Color us = (board_state.state & TURN_COLOR_BIT) ? BLACK : WHITE;
+        const Color them = us ^ BLACK;
+        constexpr Bitboard BACK_RANKS = 0xffULL | (0xffULL << 56);
+        if(popcount(board.pieces(WHITE, KING)) != 1
+            || popcount(board.pieces(BLACK, KING)) != 1
+            || (board.kind_bb[PAWN] & BACK_RANKS))
+        {
+            return false;
+        }
+        // The side to move could capture the king
+        if(board.is_attacked(lsb(board.pieces(them, KING)), us))
+            return false;
+
+        // Castling rights need the king and that rook on their squares
+        for(const Color color : { WHITE, BLACK }) {
+            const auto& bits = CASTLING_BITS[color_index(color)];
+            const uint8_t row = color == WHITE ? 7 : 0;
+            const bool queenside = !(board_state.state & (bits[0] | bits[1]));
+            const bool kingside = !(board_state.state & (bits[1] | bits[2]));
+            if(((queenside || kingside) && board.at(Position{4, row}).raw() != (KING | color))
+                || (queenside && board.at(Position{0, row}).raw() != (ROOK | color))
+                || (kingside && board.at(Position{7, row}).raw() != (ROOK | color)))
+            {
+                return false;
             }
-            case KING: {
-                // Retrieve king possible moveset
-                return king_moves(board, piece, pos, state);
+        }
+
+        // Skipped square on the third row from the opponent side, empty
+        // like the one the pawn left, with the pawn right past it
+        const auto ep = board_state.en_passant;
+        if(ep != NO_SQUARE) {
+            const int step = us == WHITE ? 8 : -8;
+            const auto occupancy = board.occupancy();
+            if(position_of(ep)[1] != (us == WHITE ? 2 : 5)
+                || (occupancy & (square_bb(ep) | square_bb(Square(ep - step))))
+                || !(board.pieces(them, PAWN) & square_bb(Square(ep + step))))
+            {
+                return false;
             }
         }
-        return {};
+        return true;
+    }
+
+    void apply_board_move(Board& board, const Move& move, uint8_t& state, Square& en_passant) {
+        uint64_t hash = 0;
+        eval::Score psq = {};
+        ::apply_move(board, move, state, en_passant, hash, psq);
     }
 }
\ No newline at end of file
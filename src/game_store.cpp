@@ -0,0 +1,287 @@
+#include "game_store.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "trace.hpp"
+
+namespace {
+    // Below this many moves per task, waking workers costs more than
+    // validating
+    constexpr size_t MIN_TASK_MOVES = 256;
+    // Slot ranges per pool thread, so uneven ranges still balance
+    constexpr size_t TASKS_PER_THREAD = 4;
+
+    bool is_standard_start(const lc::BoardState& board_state) {
+        return board_state.board_data == lc::Board::standard().board_data
+            && board_state.state == 0
+            && board_state.en_passant == lc::NO_SQUARE
+            && board_state.halfmove_clock == 0
+            && board_state.fullmove_number == 1;
+    }
+}
+
+namespace lc {
+    GameStore::ChunkPool::ChunkPool()
+        : blocks(std::make_unique<std::unique_ptr<HistoryChunk[]>[]>(MAX_BLOCKS))
+        , block_count(0)
+        , chunk_count(0) {}
+
+    uint32_t GameStore::ChunkPool::allocate() {
+        std::lock_guard lock(mutex);
+        if(!free_chunks.empty()) {
+            const auto chunk = free_chunks.back();
+            free_chunks.pop_back();
+            return chunk;
+        }
+        if(chunk_count == block_count * BLOCK_CHUNKS) {
+            assert(block_count < MAX_BLOCKS);
+            blocks[block_count++] = std::make_unique<HistoryChunk[]>(BLOCK_CHUNKS);
+        }
+        return chunk_count++;
+    }
+
+    void GameStore::ChunkPool::release(uint32_t first) {
+        std::lock_guard lock(mutex);
+        for(auto chunk = first; chunk != NO_CHUNK; chunk = (*this)[chunk].next)
+            free_chunks.push_back(chunk);
+    }
+
+    size_t GameStore::ChunkPool::memory_usage() const {
+        return MAX_BLOCKS * sizeof(blocks[0])
+            + block_count * BLOCK_CHUNKS * sizeof(HistoryChunk)
+            + free_chunks.capacity() * sizeof(uint32_t);
+    }
+
+    GameStore::GameStore(unsigned threads)
+        : game_count(0)
+        , pool(threads) {}
+
+    GameId GameStore::create() {
+        return create({ Board::standard().board_data, 0, NO_SQUARE, 0, 1 });
+    }
+
+    GameId GameStore::create(const BoardState& start) {
+        // Batches generate legal moves from it on the pool threads
+        if(!is_valid_state(start))
+            return INVALID_GAME_ID;
+        uint32_t slot;
+        if(!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            ++generations[slot];
+        }
+        else {
+            slot = uint32_t(generations.size());
+            boards.emplace_back();
+            states.emplace_back();
+            en_passants.emplace_back();
+            halfmove_clocks.emplace_back();
+            fullmove_numbers.emplace_back();
+            move_counts.emplace_back();
+            first_chunks.emplace_back();
+            last_chunks.emplace_back();
+            generations.push_back(1);
+        }
+
+        boards[slot] = start.board_data;
+        states[slot] = start.state;
+        en_passants[slot] = start.en_passant;
+        halfmove_clocks[slot] = start.halfmove_clock;
+        fullmove_numbers[slot] = start.fullmove_number;
+        move_counts[slot] = 0;
+        first_chunks[slot] = NO_CHUNK;
+        last_chunks[slot] = NO_CHUNK;
+        if(!is_standard_start(start))
+            custom_starts[slot] = start;
+        ++game_count;
+        return { slot, generations[slot] };
+    }
+
+    bool GameStore::erase(GameId id) {
+        if(!valid(id))
+            return false;
+        chunks.release(first_chunks[id.slot]);
+        custom_starts.erase(id.slot);
+        ++generations[id.slot];
+        free_slots.push_back(id.slot);
+        --game_count;
+        return true;
+    }
+
+    bool GameStore::contains(GameId id) const {
+        return valid(id);
+    }
+
+    void GameStore::reserve(size_t games) {
+        boards.reserve(games);
+        states.reserve(games);
+        en_passants.reserve(games);
+        halfmove_clocks.reserve(games);
+        fullmove_numbers.reserve(games);
+        move_counts.reserve(games);
+        first_chunks.reserve(games);
+        last_chunks.reserve(games);
+        generations.reserve(games);
+    }
+
+    std::optional<BoardState> GameStore::board_state(GameId id) const {
+        if(!valid(id))
+            return std::nullopt;
+        const auto slot = id.slot;
+        return BoardState{
+            boards[slot],
+            states[slot],
+            en_passants[slot],
+            halfmove_clocks[slot],
+            fullmove_numbers[slot]
+        };
+    }
+
+    std::optional<std::vector<PackedMove>> GameStore::history(GameId id) const {
+        if(!valid(id))
+            return std::nullopt;
+        std::vector<PackedMove> moves;
+        moves.reserve(move_counts[id.slot]);
+        auto remaining = move_counts[id.slot];
+        for(auto chunk = first_chunks[id.slot]; chunk != NO_CHUNK; chunk = chunks[chunk].next) {
+            const auto count = std::min<uint32_t>(remaining, CHUNK_MOVES);
+            moves.insert(moves.end(), chunks[chunk].moves, chunks[chunk].moves + count);
+            remaining -= count;
+        }
+        return moves;
+    }
+
+    std::optional<ChessGame> GameStore::game(GameId id) const {
+        const auto moves = history(id);
+        if(!moves.has_value())
+            return std::nullopt;
+        const auto start = custom_starts.find(id.slot);
+        auto game = start != custom_starts.end()
+            ? ChessGame(start->second)
+            : ChessGame(Board::standard());
+        game.reserve(moves->size());
+        for(const auto move : *moves)
+            game.make_move(move.to_move(game.board));
+        return game;
+    }
+
+    void GameStore::push_history(uint32_t slot, PackedMove move) {
+        const auto count = move_counts[slot];
+        if(count % CHUNK_MOVES == 0) {
+            const auto chunk = chunks.allocate();
+            chunks[chunk].next = NO_CHUNK;
+            if(last_chunks[slot] == NO_CHUNK)
+                first_chunks[slot] = chunk;
+            else
+                chunks[last_chunks[slot]].next = chunk;
+            last_chunks[slot] = chunk;
+        }
+        chunks[last_chunks[slot]].moves[count % CHUNK_MOVES] = move;
+        move_counts[slot] = count + 1;
+    }
+
+    MoveError GameStore::apply_move(const GameMove& game_move) {
+        const auto reject = [](MoveError error) {
+            LC_TRACE_COUNT(rejected[size_t(error)], 1);
+            return error;
+        };
+        if(!valid(game_move.game))
+            return reject(MoveError::UnknownGame);
+
+        const auto slot = game_move.game.slot;
+        const auto packed = game_move.move;
+        Board board(boards[slot]);
+        uint8_t state = states[slot];
+        Square en_passant = en_passants[slot];
+        const Color us = (state & TURN_COLOR_BIT) ? BLACK : WHITE;
+
+        const auto piece = board.at(packed.from_square());
+        if(piece.kind() == NONE)
+            return reject(MoveError::NoPiece);
+        if(piece.color() != us)
+            return reject(MoveError::NotYourTurn);
+
+        MoveList moves;
+        generate_legal_moves(board, us, state, en_passant, moves);
+        const auto move = std::find_if(moves.begin(), moves.end(),
+            [&](const Move& m) { return PackedMove(m) == packed; });
+        if(move == moves.end())
+            return reject(MoveError::InvalidMove);
+
+        // Captures and pawn moves are irreversible
+        const bool reset_clock = board.at(packed.to_square()).kind() != NONE
+            || packed.is_en_passant()
+            || piece.kind() == PAWN;
+        apply_board_move(board, *move, state, en_passant);
+
+        boards[slot] = board.board_data;
+        states[slot] = state ^ TURN_COLOR_BIT;
+        en_passants[slot] = en_passant;
+        halfmove_clocks[slot] = reset_clock ? 0 : halfmove_clocks[slot] + 1;
+        if(us == BLACK)
+            ++fullmove_numbers[slot];
+        push_history(slot, packed);
+        LC_TRACE_COUNT(applied, 1);
+        return MoveError::None;
+    }
+
+    void GameStore::apply_moves(std::span<const GameMove> moves, std::span<MoveError> results) {
+        assert(results.size() >= moves.size());
+        const size_t tasks = std::min(
+            size_t(pool.size()) * TASKS_PER_THREAD,
+            moves.size() / MIN_TASK_MOVES);
+        if(tasks <= 1) {
+            for(size_t i = 0; i < moves.size(); ++i)
+                results[i] = apply_move(moves[i]);
+            return;
+        }
+
+        // Entries are bucketed by slot range: every game belongs to a
+        // single task, which keeps its moves in batch order, and each
+        // task touches its own part of the arrays
+        const size_t slots = std::max<size_t>(generations.size(), 1);
+        const auto task_of = [&](const GameMove& game_move) {
+            const size_t slot = std::min<size_t>(game_move.game.slot, slots - 1);
+            return slot * tasks / slots;
+        };
+        std::vector<uint32_t> offsets(tasks + 1, 0);
+        for(const auto& game_move : moves)
+            ++offsets[task_of(game_move) + 1];
+        for(size_t t = 0; t < tasks; ++t)
+            offsets[t + 1] += offsets[t];
+        std::vector<uint32_t> order(moves.size());
+        {
+            auto next = offsets;
+            for(size_t i = 0; i < moves.size(); ++i)
+                order[next[task_of(moves[i])]++] = uint32_t(i);
+        }
+
+        pool.run(tasks, [&](size_t task) {
+            for(auto i = offsets[task]; i < offsets[task + 1]; ++i)
+                results[order[i]] = apply_move(moves[order[i]]);
+        });
+    }
+
+    std::vector<MoveError> GameStore::apply_moves(std::span<const GameMove> moves) {
+        std::vector<MoveError> results(moves.size());
+        apply_moves(moves, results);
+        return results;
+    }
+
+    size_t GameStore::memory_usage() const {
+        const size_t per_slot = sizeof(boards[0])
+            + sizeof(states[0])
+            + sizeof(en_passants[0])
+            + sizeof(halfmove_clocks[0])
+            + sizeof(fullmove_numbers[0])
+            + sizeof(move_counts[0])
+            + sizeof(first_chunks[0])
+            + sizeof(last_chunks[0])
+            + sizeof(generations[0]);
+        return generations.capacity() * per_slot
+            + free_slots.capacity() * sizeof(uint32_t)
+            + custom_starts.size() * (sizeof(uint32_t) + sizeof(BoardState) + 2 * sizeof(void*))
+            + chunks.memory_usage();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "kogge_stone.hpp"
+
+#include <atomic>
+#include <cassert>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define LC_X86 1
+    #include <immintrin.h>
+#else
+    #define LC_X86 0
+#endif
+
+namespace {
+    using lc::Bitboard;
+    using lc::kogge_stone::Backend;
+    using lc::kogge_stone::SliderQuery;
+
+    constexpr Bitboard ALL_BB = ~Bitboard(0);
+    constexpr Bitboard NOT_A_BB = ~lc::FILE_A_BB;
+    constexpr Bitboard NOT_H_BB = ~lc::FILE_H_BB;
+
+    // Squares are 'y*8 + x': +1 is x+1 and +8 is y+1. Wrap masks drop
+    // the squares a shift brings around from the other board edge
+    //   +1  / -1  straight   +8 / -8  straight
+    //   +9  / -9  diagonal   +7 / -7  diagonal
+    constexpr int SHIFTS[4] = { 1, 8, 9, 7 };
+    constexpr Bitboard LEFT_WRAPS[4]  = { NOT_A_BB, ALL_BB, NOT_A_BB, NOT_H_BB };
+    constexpr Bitboard RIGHT_WRAPS[4] = { NOT_H_BB, ALL_BB, NOT_H_BB, NOT_A_BB };
+
+    /////////////// Scalar ///////////////
+
+    // Attacks of 'gen' towards one direction, flooding over 'empty'
+    template<bool Left>
+    Bitboard occluded_attacks(Bitboard gen, Bitboard empty, int s, Bitboard wrap) {
+        const auto shift = [&](Bitboard b, int n) { return Left ? b << n : b >> n; };
+        Bitboard pro = empty & wrap;
+        gen |= pro & shift(gen, s);
+        pro &= shift(pro, s);
+        gen |= pro & shift(gen, 2*s);
+        pro &= shift(pro, 2*s);
+        gen |= pro & shift(gen, 4*s);
+        return shift(gen, s) & wrap;
+    }
+
+    Bitboard scalar_attacks(Bitboard diagonal, Bitboard straight, Bitboard occupancy) {
+        const Bitboard empty = ~occupancy;
+        Bitboard attacks = 0;
+        for(int d = 0; d < 4; ++d) {
+            const auto gen = d < 2 ? straight : diagonal;
+            attacks |= occluded_attacks<true>(gen, empty, SHIFTS[d], LEFT_WRAPS[d]);
+            attacks |= occluded_attacks<false>(gen, empty, SHIFTS[d], RIGHT_WRAPS[d]);
+        }
+        return attacks;
+    }
+
+    void scalar_batch(std::span<const SliderQuery> queries, std::span<Bitboard> out) {
+        for(size_t i = 0; i < queries.size(); ++i)
+            out[i] = scalar_attacks(queries[i].diagonal, queries[i].straight, queries[i].occupancy);
+    }
+
+#if LC_X86
+    /////////////// SSE2 ///////////////
+
+    // Lane 0 shifts left and lane 1 right, a direction and its
+    // opposite per register
+    __attribute__((target("sse2")))
+    inline __m128i shift_pair(__m128i v, int n) {
+        const __m128i count = _mm_cvtsi32_si128(n);
+        const __m128i left_lane = _mm_set_epi64x(0, -1);
+        return _mm_or_si128(
+            _mm_and_si128(_mm_sll_epi64(v, count), left_lane),
+            _mm_andnot_si128(left_lane, _mm_srl_epi64(v, count)));
+    }
+
+    __attribute__((target("sse2")))
+    Bitboard sse2_attacks(Bitboard diagonal, Bitboard straight, Bitboard occupancy) {
+        const __m128i empty = _mm_set1_epi64x(int64_t(~occupancy));
+        __m128i attacks = _mm_setzero_si128();
+        for(int d = 0; d < 4; ++d) {
+            const auto gen_bb = d < 2 ? straight : diagonal;
+            const int s = SHIFTS[d];
+            const __m128i wrap = _mm_set_epi64x(int64_t(RIGHT_WRAPS[d]), int64_t(LEFT_WRAPS[d]));
+            __m128i gen = _mm_set1_epi64x(int64_t(gen_bb));
+            __m128i pro = _mm_and_si128(empty, wrap);
+            gen = _mm_or_si128(gen, _mm_and_si128(pro, shift_pair(gen, s)));
+            pro = _mm_and_si128(pro, shift_pair(pro, s));
+            gen = _mm_or_si128(gen, _mm_and_si128(pro, shift_pair(gen, 2*s)));
+            pro = _mm_and_si128(pro, shift_pair(pro, 2*s));
+            gen = _mm_or_si128(gen, _mm_and_si128(pro, shift_pair(gen, 4*s)));
+            attacks = _mm_or_si128(attacks, _mm_and_si128(shift_pair(gen, s), wrap));
+        }
+        attacks = _mm_or_si128(attacks, _mm_unpackhi_epi64(attacks, attacks));
+        return Bitboard(_mm_cvtsi128_si64(attacks));
+    }
+
+    template<bool Left>
+    __attribute__((target("sse2")))
+    inline __m128i shift(__m128i v, int n) {
+        const __m128i count = _mm_cvtsi32_si128(n);
+        if constexpr(Left)
+            return _mm_sll_epi64(v, count);
+        else
+            return _mm_srl_epi64(v, count);
+    }
+
+    // Two queries per register, one direction at a time
+    template<bool Left>
+    __attribute__((target("sse2")))
+    inline __m128i sse2_direction(__m128i gen, __m128i empty, int s, Bitboard wrap_bb) {
+        const __m128i wrap = _mm_set1_epi64x(int64_t(wrap_bb));
+        __m128i pro = _mm_and_si128(empty, wrap);
+        gen = _mm_or_si128(gen, _mm_and_si128(pro, shift<Left>(gen, s)));
+        pro = _mm_and_si128(pro, shift<Left>(pro, s));
+        gen = _mm_or_si128(gen, _mm_and_si128(pro, shift<Left>(gen, 2*s)));
+        pro = _mm_and_si128(pro, shift<Left>(pro, 2*s));
+        gen = _mm_or_si128(gen, _mm_and_si128(pro, shift<Left>(gen, 4*s)));
+        return _mm_and_si128(shift<Left>(gen, s), wrap);
+    }
+
+    __attribute__((target("sse2")))
+    void sse2_batch(std::span<const SliderQuery> queries, std::span<Bitboard> out) {
+        size_t i = 0;
+        for(; i + 2 <= queries.size(); i += 2) {
+            const auto& a = queries[i];
+            const auto& b = queries[i + 1];
+            const __m128i diagonal = _mm_set_epi64x(int64_t(b.diagonal), int64_t(a.diagonal));
+            const __m128i straight = _mm_set_epi64x(int64_t(b.straight), int64_t(a.straight));
+            const __m128i empty = _mm_set_epi64x(int64_t(~b.occupancy), int64_t(~a.occupancy));
+            __m128i attacks = _mm_setzero_si128();
+            for(int d = 0; d < 4; ++d) {
+                const __m128i gen = d < 2 ? straight : diagonal;
+                attacks = _mm_or_si128(attacks, sse2_direction<true>(gen, empty, SHIFTS[d], LEFT_WRAPS[d]));
+                attacks = _mm_or_si128(attacks, sse2_direction<false>(gen, empty, SHIFTS[d], RIGHT_WRAPS[d]));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), attacks);
+        }
+        for(; i < queries.size(); ++i)
+            out[i] = sse2_attacks(queries[i].diagonal, queries[i].straight, queries[i].occupancy);
+    }
+
+    /////////////// AVX2 ///////////////
+
+    __attribute__((target("avx2")))
+    Bitboard avx2_attacks(Bitboard diagonal, Bitboard straight, Bitboard occupancy) {
+        // Lanes: +-1 and +-8 straight, +-9 and +-7 diagonal. Left
+        // shifts in one register, right shifts in the other
+        const __m256i s1 = _mm256_setr_epi64x(SHIFTS[0], SHIFTS[1], SHIFTS[2], SHIFTS[3]);
+        const __m256i s2 = _mm256_add_epi64(s1, s1);
+        const __m256i s4 = _mm256_add_epi64(s2, s2);
+        const __m256i left_wrap = _mm256_setr_epi64x(
+            int64_t(LEFT_WRAPS[0]), int64_t(LEFT_WRAPS[1]), int64_t(LEFT_WRAPS[2]), int64_t(LEFT_WRAPS[3]));
+        const __m256i right_wrap = _mm256_setr_epi64x(
+            int64_t(RIGHT_WRAPS[0]), int64_t(RIGHT_WRAPS[1]), int64_t(RIGHT_WRAPS[2]), int64_t(RIGHT_WRAPS[3]));
+        const __m256i empty = _mm256_set1_epi64x(int64_t(~occupancy));
+        const __m256i gen = _mm256_setr_epi64x(
+            int64_t(straight), int64_t(straight), int64_t(diagonal), int64_t(diagonal));
+
+        __m256i gl = gen;
+        __m256i gr = gen;
+        __m256i pl = _mm256_and_si256(empty, left_wrap);
+        __m256i pr = _mm256_and_si256(empty, right_wrap);
+        gl = _mm256_or_si256(gl, _mm256_and_si256(pl, _mm256_sllv_epi64(gl, s1)));
+        gr = _mm256_or_si256(gr, _mm256_and_si256(pr, _mm256_srlv_epi64(gr, s1)));
+        pl = _mm256_and_si256(pl, _mm256_sllv_epi64(pl, s1));
+        pr = _mm256_and_si256(pr, _mm256_srlv_epi64(pr, s1));
+        gl = _mm256_or_si256(gl, _mm256_and_si256(pl, _mm256_sllv_epi64(gl, s2)));
+        gr = _mm256_or_si256(gr, _mm256_and_si256(pr, _mm256_srlv_epi64(gr, s2)));
+        pl = _mm256_and_si256(pl, _mm256_sllv_epi64(pl, s2));
+        pr = _mm256_and_si256(pr, _mm256_srlv_epi64(pr, s2));
+        gl = _mm256_or_si256(gl, _mm256_and_si256(pl, _mm256_sllv_epi64(gl, s4)));
+        gr = _mm256_or_si256(gr, _mm256_and_si256(pr, _mm256_srlv_epi64(gr, s4)));
+
+        const __m256i attacks = _mm256_or_si256(
+            _mm256_and_si256(_mm256_sllv_epi64(gl, s1), left_wrap),
+            _mm256_and_si256(_mm256_srlv_epi64(gr, s1), right_wrap));
+        // Horizontal OR of the four lanes
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+        half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+        return Bitboard(_mm_cvtsi128_si64(half));
+    }
+
+    template<bool Left>
+    __attribute__((target("avx2")))
+    inline __m256i shift(__m256i v, int n) {
+        const __m128i count = _mm_cvtsi32_si128(n);
+        if constexpr(Left)
+            return _mm256_sll_epi64(v, count);
+        else
+            return _mm256_srl_epi64(v, count);
+    }
+
+    // Four queries per register, one direction at a time
+    template<bool Left>
+    __attribute__((target("avx2")))
+    inline __m256i avx2_direction(__m256i gen, __m256i empty, int s, Bitboard wrap_bb) {
+        const __m256i wrap = _mm256_set1_epi64x(int64_t(wrap_bb));
+        __m256i pro = _mm256_and_si256(empty, wrap);
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<Left>(gen, s)));
+        pro = _mm256_and_si256(pro, shift<Left>(pro, s));
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<Left>(gen, 2*s)));
+        pro = _mm256_and_si256(pro, shift<Left>(pro, 2*s));
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<Left>(gen, 4*s)));
+        return _mm256_and_si256(shift<Left>(gen, s), wrap);
+    }
+
+    __attribute__((target("avx2")))
+    void avx2_batch(std::span<const SliderQuery> queries, std::span<Bitboard> out) {
+        size_t i = 0;
+        for(; i + 4 <= queries.size(); i += 4) {
+            const auto* q = &queries[i];
+            const __m256i diagonal = _mm256_setr_epi64x(
+                int64_t(q[0].diagonal), int64_t(q[1].diagonal), int64_t(q[2].diagonal), int64_t(q[3].diagonal));
+            const __m256i straight = _mm256_setr_epi64x(
+                int64_t(q[0].straight), int64_t(q[1].straight), int64_t(q[2].straight), int64_t(q[3].straight));
+            const __m256i empty = _mm256_setr_epi64x(
+                int64_t(~q[0].occupancy), int64_t(~q[1].occupancy), int64_t(~q[2].occupancy), int64_t(~q[3].occupancy));
+            __m256i attacks = _mm256_setzero_si256();
+            for(int d = 0; d < 4; ++d) {
+                const __m256i gen = d < 2 ? straight : diagonal;
+                attacks = _mm256_or_si256(attacks, avx2_direction<true>(gen, empty, SHIFTS[d], LEFT_WRAPS[d]));
+                attacks = _mm256_or_si256(attacks, avx2_direction<false>(gen, empty, SHIFTS[d], RIGHT_WRAPS[d]));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[i]), attacks);
+        }
+        for(; i < queries.size(); ++i)
+            out[i] = avx2_attacks(queries[i].diagonal, queries[i].straight, queries[i].occupancy);
+    }
+#endif
+
+    struct Kernels {
+        Bitboard (*single)(Bitboard, Bitboard, Bitboard);
+        void (*batch)(std::span<const SliderQuery>, std::span<Bitboard>);
+    };
+
+    constexpr Kernels SCALAR_KERNELS = { scalar_attacks, scalar_batch };
+#if LC_X86
+    constexpr Kernels SSE2_KERNELS = { sse2_attacks, sse2_batch };
+    constexpr Kernels AVX2_KERNELS = { avx2_attacks, avx2_batch };
+#endif
+
+    bool supported(Backend backend) {
+#if LC_X86
+        __builtin_cpu_init();
+        switch(backend) {
+            case Backend::Scalar: return true;
+            case Backend::SSE2:   return __builtin_cpu_supports("sse2");
+            case Backend::AVX2:   return __builtin_cpu_supports("avx2");
+        }
+        return false;
+#else
+        return backend == Backend::Scalar;
+#endif
+    }
+
+    Backend detect() {
+        if(supported(Backend::AVX2))
+            return Backend::AVX2;
+        if(supported(Backend::SSE2))
+            return Backend::SSE2;
+        return Backend::Scalar;
+    }
+
+    const Kernels* kernels_of(Backend backend) {
+#if LC_X86
+        if(backend == Backend::AVX2)
+            return &AVX2_KERNELS;
+        if(backend == Backend::SSE2)
+            return &SSE2_KERNELS;
+#endif
+        return &SCALAR_KERNELS;
+    }
+
+    // Selected once, before the first query
+    struct Dispatch {
+        std::atomic<Backend>        backend;
+        std::atomic<const Kernels*> kernels;
+
+        Dispatch()
+            : backend(detect())
+            , kernels(kernels_of(backend)) {}
+    };
+
+    Dispatch& dispatch() {
+        static Dispatch instance;
+        return instance;
+    }
+}
+
+namespace lc::kogge_stone {
+    Backend backend() {
+        return dispatch().backend.load(std::memory_order_relaxed);
+    }
+
+    bool set_backend(Backend new_backend) {
+        if(!supported(new_backend))
+            return false;
+        dispatch().backend.store(new_backend, std::memory_order_relaxed);
+        dispatch().kernels.store(kernels_of(new_backend), std::memory_order_relaxed);
+        return true;
+    }
+
+    const char* backend_name(Backend backend) {
+        switch(backend) {
+            case Backend::Scalar: return "scalar";
+            case Backend::SSE2:   return "sse2";
+            case Backend::AVX2:   return "avx2";
+        }
+        return "unknown";
+    }
+
+    Bitboard slider_attacks(Bitboard diagonal, Bitboard straight, Bitboard occupancy) {
+        return dispatch().kernels.load(std::memory_order_relaxed)->single(diagonal, straight, occupancy);
+    }
+
+    void slider_attacks(std::span<const SliderQuery> queries, std::span<Bitboard> out) {
+        assert(out.size() >= queries.size());
+        dispatch().kernels.load(std::memory_order_relaxed)->batch(queries, out);
+    }
+}
\ No newline at end of file
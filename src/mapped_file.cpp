@@ -0,0 +1,100 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Non null pointer for empty files, which can't be mapped
+    constexpr char EMPTY_FILE[1] = {};
+}
+
+namespace lc {
+    MappedFile::MappedFile()
+        : begin(nullptr)
+        , length(0)
+        , mapped(false) {}
+
+    MappedFile::MappedFile(const std::string& path)
+        : MappedFile()
+    {
+        open(path);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : begin(std::exchange(other.begin, nullptr))
+        , length(std::exchange(other.length, 0))
+        , mapped(std::exchange(other.mapped, false))
+        , buffer(std::move(other.buffer)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if(this != &other) {
+            close();
+            begin = std::exchange(other.begin, nullptr);
+            length = std::exchange(other.length, 0);
+            mapped = std::exchange(other.mapped, false);
+            buffer = std::move(other.buffer);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path) {
+        close();
+    #if defined(__linux__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat info;
+        if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            length = size_t(info.st_size);
+            if(length == 0) {
+                begin = EMPTY_FILE;
+                ::close(fd);
+                return true;
+            }
+            void* memory = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(memory != MAP_FAILED) {
+                // Files are mostly read front to back
+                madvise(memory, length, MADV_SEQUENTIAL);
+                begin = static_cast<const char*>(memory);
+                mapped = true;
+                ::close(fd);
+                return true;
+            }
+        }
+        length = 0;
+        ::close(fd);
+    #endif
+        std::ifstream file(path, std::ios::binary);
+        if(!file)
+            return false;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if(file.bad())
+            return false;
+        length = buffer.size();
+        begin = buffer.empty() ? EMPTY_FILE : buffer.data();
+        return true;
+    }
+
+    void MappedFile::close() {
+    #if defined(__linux__)
+        if(mapped)
+            munmap(const_cast<char*>(begin), length);
+    #endif
+        begin = nullptr;
+        length = 0;
+        mapped = false;
+        buffer.clear();
+    }
+}
\ No newline at end of file
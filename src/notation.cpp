@@ -0,0 +1,395 @@
+#include "notation.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include "piece_moves.hpp"
+
+namespace {
+    // Piece kind from a FEN/SAN letter, NONE if invalid
+    constexpr uint8_t kind_from_char(char c) {
+        switch(c | 0x20) {
+            case 'p': return PAWN;
+            case 'n': return KNIGHT;
+            case 'b': return BISHOP;
+            case 'r': return ROOK;
+            case 'q': return QUEEN;
+            case 'k': return KING;
+        }
+        return NONE;
+    }
+
+    // FEN letters indexed by raw piece
+    constexpr char PIECE_CHARS[16] = {
+        ' ', 'P', 'N', 'B', 'R', 'Q', 'K', ' ',
+        ' ', 'p', 'n', 'b', 'r', 'q', 'k', ' '
+    };
+
+    // Splits the next space separated field out of 'str'
+    std::string_view next_field(std::string_view& str) {
+        const auto begin = str.find_first_not_of(' ');
+        if(begin == std::string_view::npos) {
+            str = {};
+            return {};
+        }
+        str.remove_prefix(begin);
+        const auto end = std::min(str.find(' '), str.size());
+        const auto field = str.substr(0, end);
+        str.remove_prefix(end);
+        return field;
+    }
+
+    // Placement characters decoded by a single lookup
+    struct PlacementChar {
+        uint8_t piece   = NONE;
+        // Squares covered
+        uint8_t advance = 0;
+        bool    slash   = false;
+        bool    invalid = true;
+    };
+
+    constexpr std::array<PlacementChar,256> make_placement_chars() {
+        std::array<PlacementChar,256> chars = {};
+        for(char c : { 'p', 'n', 'b', 'r', 'q', 'k' }) {
+            chars[uint8_t(c)] = { uint8_t(kind_from_char(c) | BLACK), 1, false, false };
+            chars[uint8_t(c - 0x20)] = { uint8_t(kind_from_char(c) | WHITE), 1, false, false };
+        }
+        for(char c = '1'; c <= '8'; ++c)
+            chars[uint8_t(c)] = { NONE, uint8_t(c - '0'), false, false };
+        chars['/'] = { NONE, 0, true, false };
+        return chars;
+    }
+
+    constexpr auto PLACEMENT_CHARS = make_placement_chars();
+
+    // Piece placement field into board rows, pieces are written
+    // straight into the rows and the bitboards are built once later.
+    // Branchless, characters are too random for the branch predictor
+    bool parse_placement(std::string_view placement, std::array<uint64_t,8>& rows) {
+        rows = {};
+        unsigned x = 0;
+        unsigned y = 0;
+        unsigned kings[2] = { 0, 0 };
+        bool invalid = false;
+        for(const char c : placement) {
+            const auto& decoded = PLACEMENT_CHARS[uint8_t(c)];
+            invalid |= decoded.invalid
+                | (x + decoded.advance > 8)
+                | (decoded.slash & ((x != 8) | (y == 7)));
+            rows[y & 7] |= uint64_t(decoded.piece) << ((x & 7) * 8);
+            kings[0] += decoded.piece == (KING | WHITE);
+            kings[1] += decoded.piece == (KING | BLACK);
+            y += decoded.slash;
+            x = decoded.slash ? 0 : x + decoded.advance;
+        }
+        // Exactly one king per color
+        return !invalid && x == 8 && y == 7 && kings[0] == 1 && kings[1] == 1;
+    }
+
+    // Optional clock field, 'value' is left untouched if missing
+    bool parse_clock(std::string_view field, uint16_t& value) {
+        if(field.empty())
+            return true;
+        const auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == std::errc() && result.ptr == field.data() + field.size();
+    }
+}
+
+namespace lc {
+    std::string square_name(Square sq) {
+        const auto pos = position_of(sq);
+        return { char('a' + pos[0]), char('8' - pos[1]) };
+    }
+
+    std::optional<Square> parse_square(std::string_view str) {
+        if(str.size() != 2
+            || str[0] < 'a' || str[0] > 'h'
+            || str[1] < '1' || str[1] > '8')
+        {
+            return std::nullopt;
+        }
+        return square_of({ uint8_t(str[0] - 'a'), uint8_t('8' - str[1]) });
+    }
+
+    std::string move_name(const Move& move) {
+        static const char promotion_chars[7] = { ' ', ' ', 'n', 'b', 'r', 'q', ' ' };
+        auto name = square_name(square_of(move.from())) + square_name(square_of(move.to()));
+        const auto packed = PackedMove(move);
+        if(packed.is_promotion())
+            name += promotion_chars[packed.promotion_kind()];
+        return name;
+    }
+
+    std::optional<Move> parse_move(const ChessGame& game, std::string_view name) {
+        if(name.size() != 4 && name.size() != 5)
+            return std::nullopt;
+        const auto from = parse_square(name.substr(0, 2));
+        const auto to = parse_square(name.substr(2, 2));
+        if(!from.has_value() || !to.has_value())
+            return std::nullopt;
+        const uint8_t promotion = name.size() == 5 ? kind_from_char(name[4]) : NONE;
+        if(name.size() == 5 && (promotion == NONE || promotion == PAWN || promotion == KING))
+            return std::nullopt;
+
+        MoveList moves;
+        game.legal_moves(moves);
+        for(const auto& move : moves) {
+            const auto packed = PackedMove(move);
+            if(packed.from_square() == *from
+                && packed.to_square() == *to
+                && (packed.is_promotion() ? packed.promotion_kind() : NONE) == promotion)
+            {
+                return move;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Move> parse_san(const ChessGame& game, std::string_view san) {
+        // Check, mate and annotation suffixes
+        while(!san.empty() && (san.back() == '+' || san.back() == '#'
+            || san.back() == '!' || san.back() == '?'))
+        {
+            san.remove_suffix(1);
+        }
+        if(san.empty())
+            return std::nullopt;
+
+        MoveList moves;
+        game.legal_moves(moves);
+
+        // Castling, also written with zeros
+        if(san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+            const uint8_t to_x = san.size() == 3 ? 6 : 2;
+            for(const auto& move : moves)
+                if(PackedMove(move).is_castling() && move.to()[0] == to_x)
+                    return move;
+            return std::nullopt;
+        }
+
+        uint8_t kind = PAWN;
+        if(san[0] >= 'A' && san[0] <= 'Z') {
+            kind = kind_from_char(san[0]);
+            if(kind == NONE || kind == PAWN)
+                return std::nullopt;
+            san.remove_prefix(1);
+        }
+
+        // Promotion, "e8=Q" or "e8Q", any letter case
+        uint8_t promotion = NONE;
+        if(san.size() >= 2
+            && (san[san.size() - 2] == '=' || san[san.size() - 2] == '1' || san[san.size() - 2] == '8')
+            && kind_from_char(san.back()) != NONE)
+        {
+            promotion = kind_from_char(san.back());
+            if(kind != PAWN || promotion == NONE || promotion == PAWN || promotion == KING)
+                return std::nullopt;
+            san.remove_suffix(1);
+            if(!san.empty() && san.back() == '=')
+                san.remove_suffix(1);
+        }
+
+        if(san.size() < 2)
+            return std::nullopt;
+        const auto to = parse_square(san.substr(san.size() - 2));
+        if(!to.has_value())
+            return std::nullopt;
+        san.remove_suffix(2);
+
+        // Disambiguation file and/or rank, capture mark is optional
+        int from_x = -1;
+        int from_y = -1;
+        for(const char c : san) {
+            if(c >= 'a' && c <= 'h')
+                from_x = c - 'a';
+            else if(c >= '1' && c <= '8')
+                from_y = '8' - c;
+            else if(c != 'x' && c != ':')
+                return std::nullopt;
+        }
+
+        std::optional<Move> found;
+        for(const auto& move : moves) {
+            const auto packed = PackedMove(move);
+            if(packed.to_square() != *to
+                || packed.is_castling()
+                || game.board.at(packed.from_square()).kind() != kind
+                || (from_x >= 0 && move.from()[0] != from_x)
+                || (from_y >= 0 && move.from()[1] != from_y))
+            {
+                continue;
+            }
+            // Missing promotion piece defaults to a queen
+            if(packed.is_promotion()
+                && packed.promotion_kind() != (promotion == NONE ? QUEEN : promotion))
+            {
+                continue;
+            }
+            if(!packed.is_promotion() && promotion != NONE)
+                continue;
+            if(found.has_value())
+                return std::nullopt;
+            found = move;
+        }
+        return found;
+    }
+
+    std::optional<ChessGame> game_from_fen(std::string_view fen, bool free_game) {
+        const auto board_state = state_from_fen(fen);
+        if(!board_state.has_value())
+            return std::nullopt;
+        return ChessGame(*board_state, free_game);
+    }
+
+    std::optional<BoardState> state_from_fen(std::string_view fen) {
+        BoardState board_state = { {}, 0, NO_SQUARE, 0, 1 };
+        auto& state = board_state.state;
+
+        // Piece placement, from rank 8 to rank 1
+        if(!parse_placement(next_field(fen), board_state.board_data))
+            return std::nullopt;
+
+        // Side to move
+        {
+            const auto turn = next_field(fen);
+            if(turn == "b")
+                state |= TURN_COLOR_BIT;
+            else if(turn != "w")
+                return std::nullopt;
+        }
+
+        // Castling rights, a missing right is stored as a moved rook
+        {
+            const auto castling = next_field(fen);
+            if(castling.empty())
+                return std::nullopt;
+            state |= WHITE_KINGSIDE_ROOK_MOVED_BIT | WHITE_QUEENSIDE_ROOK_MOVED_BIT
+                | BLACK_KINGSIDE_ROOK_MOVED_BIT | BLACK_QUEENSIDE_ROOK_MOVED_BIT;
+            for(const char c : castling) {
+                switch(c) {
+                    case 'K': state &= ~WHITE_KINGSIDE_ROOK_MOVED_BIT; break;
+                    case 'Q': state &= ~WHITE_QUEENSIDE_ROOK_MOVED_BIT; break;
+                    case 'k': state &= ~BLACK_KINGSIDE_ROOK_MOVED_BIT; break;
+                    case 'q': state &= ~BLACK_QUEENSIDE_ROOK_MOVED_BIT; break;
+                    case '-': break;
+                    default: return std::nullopt;
+                }
+            }
+            // Rights without the king and that rook on their squares
+            // are dropped
+            const Board board(board_state.board_data);
+            for(const Color color : { WHITE, BLACK }) {
+                const auto& bits = CASTLING_BITS[color_index(color)];
+                const uint8_t row = color == WHITE ? 7 : 0;
+                if(board.at(Position{4, row}).raw() != (KING | color))
+                    state |= bits[0] | bits[2];
+                if(board.at(Position{0, row}).raw() != (ROOK | color))
+                    state |= bits[0];
+                if(board.at(Position{7, row}).raw() != (ROOK | color))
+                    state |= bits[2];
+            }
+            // No rights left on a side means the king moved
+            for(const auto& bits : CASTLING_BITS)
+                if((state & bits[0]) && (state & bits[2]))
+                    state |= bits[1];
+        }
+
+        // En passant, checked with the rest of the position below
+        {
+            const auto square = next_field(fen);
+            if(square != "-") {
+                const auto sq = parse_square(square);
+                if(!sq.has_value())
+                    return std::nullopt;
+                board_state.en_passant = *sq;
+            }
+        }
+
+        // Halfmove clock and fullmove number
+        if(!parse_clock(next_field(fen), board_state.halfmove_clock)
+            || !parse_clock(next_field(fen), board_state.fullmove_number))
+        {
+            return std::nullopt;
+        }
+        if(board_state.fullmove_number == 0)
+            board_state.fullmove_number = 1;
+
+        if(!is_valid_state(board_state))
+            return std::nullopt;
+
+        // En passant only kept if it can be captured (same as 'apply_move')
+        if(board_state.en_passant != NO_SQUARE) {
+            const Color us = (state & TURN_COLOR_BIT) ? BLACK : WHITE;
+            const auto pawns = Board(board_state.board_data).pieces(us, PAWN);
+            if(!(pawn_attacks[color_index(us ^ BLACK)][board_state.en_passant] & pawns))
+                board_state.en_passant = NO_SQUARE;
+        }
+        return board_state;
+    }
+
+    std::optional<Board> board_from_fen(std::string_view fen) {
+        std::array<uint64_t,8> rows;
+        if(!parse_placement(next_field(fen), rows))
+            return std::nullopt;
+        return Board(rows);
+    }
+
+    std::string game_to_fen(const ChessGame& game) {
+        return state_to_fen(game.board_state());
+    }
+
+    std::string state_to_fen(const BoardState& board_state) {
+        const auto state = board_state.state;
+        auto fen = board_to_fen(Board(board_state.board_data));
+
+        fen += (state & TURN_COLOR_BIT) ? " b " : " w ";
+
+        // Castling right available while neither its rook nor the
+        // king have moved
+        const size_t castling_begin = fen.size();
+        const char castling_chars[2][2] = { { 'K', 'Q' }, { 'k', 'q' } };
+        for(size_t color = 0; color < 2; ++color) {
+            const auto& bits = CASTLING_BITS[color];
+            if(!(state & (bits[1] | bits[2])))
+                fen += castling_chars[color][0];
+            if(!(state & (bits[1] | bits[0])))
+                fen += castling_chars[color][1];
+        }
+        if(fen.size() == castling_begin)
+            fen += '-';
+
+        fen += ' ';
+        fen += board_state.en_passant == NO_SQUARE ? "-" : square_name(board_state.en_passant);
+        fen += ' ';
+        fen += std::to_string(board_state.halfmove_clock);
+        fen += ' ';
+        fen += std::to_string(board_state.fullmove_number);
+        return fen;
+    }
+
+    std::string board_to_fen(const Board& board) {
+        std::string fen;
+        fen.reserve(72);
+        for(uint8_t y = 0; y < 8; ++y) {
+            if(y != 0)
+                fen += '/';
+            const auto row = board.board_data[y];
+            char empty = 0;
+            for(uint8_t x = 0; x < 8; ++x) {
+                const auto raw = uint8_t(row >> (x*8));
+                if(raw == NONE) {
+                    ++empty;
+                    continue;
+                }
+                if(empty) {
+                    fen += char('0' + empty);
+                    empty = 0;
+                }
+                fen += PIECE_CHARS[raw & 0x0f];
+            }
+            if(empty)
+                fen += char('0' + empty);
+        }
+        return fen;
+    }
+}
\ No newline at end of file
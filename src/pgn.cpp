@@ -0,0 +1,390 @@
+#include "pgn.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "notation.hpp"
+
+namespace {
+    using lc::PgnGame;
+    using lc::PgnStats;
+
+    // Input is read this much at a time, then cut at the last game
+    // boundary
+    constexpr size_t CHUNK_SIZE = 4 << 20;
+
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Characters ending a movetext token
+    bool is_delimiter(char c) {
+        return is_space(c) || c == '{' || c == '}' || c == '(' || c == ')'
+            || c == '[' || c == ']' || c == ';';
+    }
+
+    std::optional<uint8_t> parse_result(std::string_view token) {
+        if(token == "1-0") return RESULT_WHITE_WINS;
+        if(token == "0-1") return RESULT_BLACK_WINS;
+        if(token == "1/2-1/2") return RESULT_DRAW;
+        if(token == "*") return RESULT_UNKNOWN;
+        return std::nullopt;
+    }
+
+    // Start of the last game in 'text', a tag line after a blank
+    // line. 0 if there's none past the beginning
+    size_t last_game_start(std::string_view text) {
+        size_t pos = text.size();
+        while(pos > 0) {
+            pos = text.rfind("\n[", pos - 1);
+            if(pos == std::string_view::npos)
+                return 0;
+            // Previous line must be blank
+            size_t prev = pos;
+            while(prev > 0 && (text[prev - 1] == ' ' || text[prev - 1] == '\t' || text[prev - 1] == '\r'))
+                --prev;
+            if(prev == 0 || text[prev - 1] == '\n')
+                return pos + 1;
+        }
+        return 0;
+    }
+
+    // Movetext and tags state of the game being parsed
+    class GameParser {
+        private:
+        const std::function<void(PgnGame&&)>& on_game;
+        std::vector<std::pair<std::string_view,std::string_view>> tags;
+        std::optional<lc::ChessGame> game;
+        bool     valid;
+        size_t   index;
+
+        public:
+        PgnStats stats;
+
+        GameParser(const std::function<void(PgnGame&&)>& _on_game)
+            : on_game(_on_game)
+            , valid(true)
+            , index(0) {}
+
+        bool in_game() const { return game.has_value() || !tags.empty(); }
+        bool in_movetext() const { return game.has_value(); }
+
+        void add_tag(std::string_view name, std::string_view value) {
+            tags.emplace_back(name, value);
+        }
+
+        void add_move(std::string_view san) {
+            start();
+            if(!valid)
+                return;
+            const auto move = lc::parse_san(*game, san);
+            if(!move.has_value()) {
+                valid = false;
+                return;
+            }
+            game->make_move(*move);
+            ++stats.moves;
+        }
+
+        void finish(uint8_t result) {
+            start();
+            ++stats.games;
+            if(valid)
+                on_game({ index, std::move(tags), std::move(*game), result });
+            else
+                ++stats.invalid_games;
+            ++index;
+            tags = {};
+            game.reset();
+            valid = true;
+        }
+
+        private:
+        // Starting position comes from the FEN tag, if any
+        void start() {
+            if(game.has_value())
+                return;
+            const auto fen = std::find_if(tags.begin(), tags.end(),
+                [](const auto& tag) { return tag.first == "FEN"; });
+            if(fen != tags.end()) {
+                game = lc::game_from_fen(fen->second);
+                if(!game.has_value()) {
+                    valid = false;
+                    game.emplace(lc::Board::standard());
+                }
+            }
+            else {
+                game.emplace(lc::Board::standard());
+            }
+        }
+    };
+
+    // Parsed games of a chunk, waiting for their turn to be emitted
+    struct ChunkResult {
+        // Owns the text tags point into
+        std::unique_ptr<std::string> text;
+        std::vector<PgnGame>         games;
+        PgnStats                     stats;
+    };
+
+    struct Chunk {
+        size_t                       sequence;
+        std::unique_ptr<std::string> text;
+    };
+}
+
+namespace lc {
+    PgnStats parse_pgn_games(
+        std::string_view text,
+        const std::function<void(PgnGame&&)>& on_game)
+    {
+        GameParser parser(on_game);
+        size_t pos = 0;
+        const auto skip_to = [&](char c) {
+            pos = std::min(text.find(c, pos), text.size());
+            if(pos < text.size())
+                ++pos;
+        };
+
+        while(pos < text.size()) {
+            const char c = text[pos];
+            if(is_space(c)) {
+                ++pos;
+            }
+            // Tag pair, starts a new game if moves came before
+            else if(c == '[') {
+                if(parser.in_movetext())
+                    parser.finish(RESULT_UNKNOWN);
+                const auto line_end = std::min(text.find('\n', pos), text.size());
+                const auto line = text.substr(pos + 1, line_end - pos - 1);
+                pos = line_end;
+                const auto name_end = std::min(line.find_first_of(" \t\""), line.size());
+                const auto value_begin = line.find('"');
+                const auto value_end = line.rfind('"');
+                if(value_begin != std::string_view::npos && value_end > value_begin)
+                    parser.add_tag(line.substr(0, name_end), line.substr(value_begin + 1, value_end - value_begin - 1));
+            }
+            // Comments
+            else if(c == '{') {
+                skip_to('}');
+            }
+            else if(c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n'))) {
+                skip_to('\n');
+            }
+            // Variations, possibly nested, with comments inside
+            else if(c == '(') {
+                int depth = 0;
+                while(pos < text.size()) {
+                    const char v = text[pos];
+                    if(v == '{') {
+                        skip_to('}');
+                        continue;
+                    }
+                    ++pos;
+                    if(v == '(')
+                        ++depth;
+                    else if(v == ')' && --depth == 0)
+                        break;
+                }
+            }
+            else {
+                const auto begin = pos;
+                while(pos < text.size() && !is_delimiter(text[pos]))
+                    ++pos;
+                // Stray closing brackets
+                if(pos == begin) {
+                    ++pos;
+                    continue;
+                }
+                auto token = text.substr(begin, pos - begin);
+
+                if(const auto result = parse_result(token)) {
+                    if(parser.in_game())
+                        parser.finish(*result);
+                    continue;
+                }
+                // Numeric annotation glyph
+                if(token[0] == '$')
+                    continue;
+                // Move number, possibly glued to the move ("1.e4")
+                if(token[0] >= '0' && token[0] <= '9' && !token.starts_with("0-0")) {
+                    token.remove_prefix(std::min(token.find_first_not_of("0123456789"), token.size()));
+                    if(token.empty() || token[0] != '.')
+                        continue;
+                }
+                token.remove_prefix(std::min(token.find_first_not_of('.'), token.size()));
+                if(!token.empty())
+                    parser.add_move(token);
+            }
+        }
+        // Last game without a result
+        if(parser.in_game())
+            parser.finish(RESULT_UNKNOWN);
+        return parser.stats;
+    }
+
+    PgnStats read_pgn(std::istream& input, const PgnCallback& callback, unsigned threads) {
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        // Chunks read ahead or parsed but not emitted yet
+        const size_t max_in_flight = 2 * threads + 2;
+
+        std::mutex mutex;
+        std::condition_variable queue_cv;
+        std::condition_variable space_cv;
+        std::deque<Chunk> queue;
+        std::map<size_t,ChunkResult> ready;
+        size_t in_flight = 0;
+        size_t next_sequence = 0;
+        bool done_reading = false;
+
+        // Emitting state, only touched while holding 'emit_mutex'
+        std::mutex emit_mutex;
+        PgnStats stats;
+
+        // Whoever completes the next chunk in order emits it and any
+        // chunk that completed before, the rest return right away
+        const auto emit_ready = [&]() {
+            while(true) {
+                if(!emit_mutex.try_lock())
+                    return;
+                while(true) {
+                    ChunkResult result;
+                    {
+                        std::lock_guard lock(mutex);
+                        const auto it = ready.find(next_sequence);
+                        if(it == ready.end())
+                            break;
+                        result = std::move(it->second);
+                        ready.erase(it);
+                    }
+                    for(auto& game : result.games) {
+                        game.index += stats.games;
+                        if(callback)
+                            callback(game);
+                    }
+                    stats.games += result.stats.games;
+                    stats.invalid_games += result.stats.invalid_games;
+                    stats.moves += result.stats.moves;
+                    {
+                        std::lock_guard lock(mutex);
+                        ++next_sequence;
+                        --in_flight;
+                    }
+                    space_cv.notify_one();
+                }
+                emit_mutex.unlock();
+                // A chunk may have completed while emitting
+                std::lock_guard lock(mutex);
+                if(!ready.contains(next_sequence))
+                    return;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                while(true) {
+                    Chunk chunk;
+                    {
+                        std::unique_lock lock(mutex);
+                        queue_cv.wait(lock, [&]() { return !queue.empty() || done_reading; });
+                        if(queue.empty())
+                            return;
+                        chunk = std::move(queue.front());
+                        queue.pop_front();
+                    }
+                    ChunkResult result;
+                    result.stats = parse_pgn_games(*chunk.text, [&](PgnGame&& game) {
+                        result.games.push_back(std::move(game));
+                    });
+                    result.text = std::move(chunk.text);
+                    {
+                        std::lock_guard lock(mutex);
+                        ready.emplace(chunk.sequence, std::move(result));
+                    }
+                    emit_ready();
+                }
+            });
+        }
+
+        // Reading happens on this thread, while workers parse
+        std::string buffer;
+        size_t sequence = 0;
+        bool first = true;
+        while(true) {
+            const auto old_size = buffer.size();
+            buffer.resize(old_size + CHUNK_SIZE);
+            input.read(buffer.data() + old_size, std::streamsize(CHUNK_SIZE));
+            buffer.resize(old_size + size_t(input.gcount()));
+            const bool end = !input;
+
+            // UTF-8 byte order mark
+            if(first && buffer.starts_with("\xEF\xBB\xBF"))
+                buffer.erase(0, 3);
+            first = false;
+
+            // Games are never split across chunks, a chunk with a
+            // single unfinished game keeps growing
+            const size_t cut = end ? buffer.size() : last_game_start(buffer);
+            if(cut > 0) {
+                auto text = std::make_unique<std::string>(buffer, 0, cut);
+                buffer.erase(0, cut);
+                std::unique_lock lock(mutex);
+                space_cv.wait(lock, [&]() { return in_flight < max_in_flight; });
+                ++in_flight;
+                queue.push_back({ sequence++, std::move(text) });
+                queue_cv.notify_one();
+            }
+            if(end)
+                break;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            done_reading = true;
+        }
+        queue_cv.notify_all();
+        for(auto& worker : workers)
+            worker.join();
+        emit_ready();
+        return stats;
+    }
+
+    std::optional<PgnStats> read_pgn_file(
+        const std::string& path,
+        const PgnCallback& callback,
+        unsigned threads)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if(!file)
+            return std::nullopt;
+        return read_pgn(file, callback, threads);
+    }
+
+    std::optional<PgnStats> pgn_to_archive(
+        const std::string& pgn_path,
+        const std::string& archive_path,
+        unsigned threads)
+    {
+        std::ifstream file(pgn_path, std::ios::binary);
+        if(!file)
+            return std::nullopt;
+        ArchiveWriter writer(archive_path);
+        if(!writer.is_open())
+            return std::nullopt;
+        // Callbacks are serialized, the writer needs no locking
+        const auto stats = read_pgn(file, [&](const PgnGame& game) {
+            writer.add_game(game.game, game.result);
+        }, threads);
+        if(!writer.close())
+            return std::nullopt;
+        return stats;
+    }
+}
\ No newline at end of file
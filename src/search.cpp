@@ -0,0 +1,529 @@
+#include "search.hpp"
+
+#include "move_picker.hpp"
+#include "tablebase.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+namespace {
+    using namespace lc;
+    using Clock = std::chrono::steady_clock;
+
+    // Late move reductions, indexed by depth and move number
+    const auto REDUCTIONS = []() {
+        std::array<std::array<int8_t,64>,64> table = {};
+        for(int depth = 1; depth < 64; ++depth)
+            for(int moves = 1; moves < 64; ++moves)
+                table[depth][moves] = int8_t(0.75 + std::log(depth) * std::log(moves) / 2.25);
+        return table;
+    }();
+
+    bool has_non_pawn_material(const Board& board, Color us) {
+        return board.pieces(us) & ~board.kind_bb[PAWN] & ~board.kind_bb[KING];
+    }
+
+    // Mate scores are stored relative to the node, not to the root
+    int score_to_tt(int score, int ply) {
+        if(score >= SCORE_MATE_IN_MAX_PLY) return score + ply;
+        if(score <= -SCORE_MATE_IN_MAX_PLY) return score - ply;
+        return score;
+    }
+
+    int score_from_tt(int score, int ply) {
+        if(score >= SCORE_MATE_IN_MAX_PLY) return score - ply;
+        if(score <= -SCORE_MATE_IN_MAX_PLY) return score + ply;
+        return score;
+    }
+
+    // Lazy SMP depth skipping of helper threads, so they spread
+    // over different iterations than the main thread
+    constexpr int SKIP_SIZE[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+    constexpr int SKIP_PHASE[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    // Shared by all threads of a search
+    struct SharedState {
+        const SearchLimits&      limits;
+        // Requested by the caller
+        const std::atomic<bool>& stop;
+        // Set by the main thread once it's done, stops helpers
+        std::atomic<bool>        done;
+        // Nodes of every thread, published every 1024 nodes
+        std::atomic<uint64_t>    nodes;
+        Clock::time_point        start;
+    };
+
+    class Searcher {
+        private:
+        ChessGame                game;
+        TranspositionTable&      tt;
+        SharedState&             shared;
+        const SearchLimits&      limits;
+        // 0 is the main thread
+        unsigned                 id;
+        uint64_t                 nodes;
+        uint64_t                 published_nodes;
+        bool                     stopped;
+
+        // Triangular principal variation table
+        PackedMove pv[MAX_PLY + 1][MAX_PLY + 1];
+        int        pv_length[MAX_PLY + 1];
+        // Move ordering, kept across iterations
+        Killers      killers[MAX_PLY + 1];
+        HistoryTable history;
+
+        public:
+        Searcher(
+            const ChessGame& _game,
+            TranspositionTable& _tt,
+            SharedState& _shared,
+            unsigned _id)
+            : game(_game)
+            , tt(_tt)
+            , shared(_shared)
+            , limits(_shared.limits)
+            , id(_id)
+            , nodes(0)
+            , published_nodes(0)
+            , stopped(false)
+            , killers{}
+        {
+            // Making moves inside the search never allocates
+            game.reserve(MAX_PLY + 1);
+        }
+
+        SearchResult iterate(const SearchCallback& on_iteration);
+
+        private:
+        int negamax(int alpha, int beta, int depth, int ply, bool null_allowed);
+        // Captures only, until the position is quiet
+        int quiescence(int alpha, int beta, int ply);
+        // Exact score of an endgame in the tables, mates counted
+        // from the root
+        std::optional<int> probe_tablebases(int ply) const;
+        int64_t elapsed() const;
+        bool should_stop();
+        SearchResult result(int score, int depth);
+        // Quiet move 'best' caused a beta cutoff after 'tried' quiets
+        void update_quiet_stats(PackedMove best, const PackedMove* tried, size_t tried_count, int depth, int ply);
+        bool skip_depth(int depth) const;
+
+        public:
+        // Nodes of every thread, exact for this one
+        uint64_t total_nodes() const {
+            return shared.nodes.load(std::memory_order_relaxed) + nodes - published_nodes;
+        }
+        uint64_t own_nodes() const { return nodes; }
+    };
+
+    std::optional<int> Searcher::probe_tablebases(int ply) const {
+        if(!limits.tablebases
+            || size_t(popcount(game.board.occupancy())) > limits.tablebases->max_pieces())
+        {
+            return std::nullopt;
+        }
+        const auto result = limits.tablebases->probe(game);
+        if(!result.has_value())
+            return std::nullopt;
+        // Mates past 'MAX_PLY' (long KRvKN lines) would fall below the
+        // mate band, where the transposition table doesn't adjust
+        // scores by ply. They're scored just below it instead
+        const int mate = ply + result->dtm < MAX_PLY
+            ? SCORE_MATE - ply - result->dtm
+            : SCORE_MATE_IN_MAX_PLY - 1;
+        switch(result->wdl) {
+            case tablebase::Wdl::Win:  return mate;
+            case tablebase::Wdl::Loss: return -mate;
+            case tablebase::Wdl::Draw: return 0;
+        }
+        return std::nullopt;
+    }
+
+    int64_t Searcher::elapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - shared.start).count();
+    }
+
+    bool Searcher::should_stop() {
+        if(shared.stop.load(std::memory_order_relaxed)
+            || shared.done.load(std::memory_order_relaxed))
+        {
+            stopped = true;
+            return true;
+        }
+        // Shared counters and clock are only touched every 1024 nodes
+        if(nodes - published_nodes >= 1024) {
+            const auto total = shared.nodes.fetch_add(nodes - published_nodes, std::memory_order_relaxed)
+                + (nodes - published_nodes);
+            published_nodes = nodes;
+            if((limits.nodes && total >= limits.nodes)
+                || (limits.movetime && elapsed() >= limits.movetime))
+            {
+                stopped = true;
+            }
+        }
+        return stopped;
+    }
+
+    bool Searcher::skip_depth(int depth) const {
+        if(id == 0)
+            return false;
+        const auto i = (id - 1) % 20;
+        return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2;
+    }
+
+    int Searcher::negamax(int alpha, int beta, int depth, int ply, bool null_allowed) {
+        pv_length[ply] = ply;
+        const Color us = game.turn();
+        const bool checked = game.is_check();
+        // Check extension
+        if(checked)
+            ++depth;
+
+        if(ply >= MAX_PLY)
+            return game.evaluate();
+        if(ply > 0) {
+            // Draws by repetition or the fifty move rule come first, the
+            // tables and transposition entries don't know the path
+            if(game.repetitions() >= 1 || game.is_fifty_move_rule())
+                return 0;
+            const auto tb_score = probe_tablebases(ply);
+            if(tb_score.has_value())
+                return *tb_score;
+        }
+        if(depth <= 0)
+            return quiescence(alpha, beta, ply);
+        if(should_stop())
+            return 0;
+
+        const bool root = ply == 0;
+        const bool pv_node = beta - alpha > 1;
+
+        if(!root) {
+            // Mate distance pruning
+            alpha = std::max(alpha, -SCORE_MATE + ply);
+            beta = std::min(beta, SCORE_MATE - ply - 1);
+            if(alpha >= beta)
+                return alpha;
+        }
+
+        const auto key = game.hash();
+        TTData tt_data{};
+        const bool tt_hit = tt.probe(key, tt_data);
+        if(tt_hit && !pv_node && tt_data.depth >= depth) {
+            const int tt_score = score_from_tt(tt_data.score, ply);
+            if((tt_data.bound == BOUND_EXACT)
+                || (tt_data.bound == BOUND_LOWER && tt_score >= beta)
+                || (tt_data.bound == BOUND_UPPER && tt_score <= alpha))
+            {
+                return tt_score;
+            }
+        }
+
+        const int static_eval = checked
+            ? -SCORE_INFINITE
+            : (tt_hit ? tt_data.eval : game.evaluate());
+
+        // Null move pruning, if passing the turn still beats beta
+        // the position is good enough to skip a reduced search
+        if(!pv_node && !checked && null_allowed
+            && depth >= 3
+            && static_eval >= beta
+            && has_non_pawn_material(game.board, us))
+        {
+            const int r = 3 + depth / 4;
+            game.make_null_move();
+            const int score = -negamax(-beta, -beta + 1, depth - 1 - r, ply + 1, false);
+            game.undo();
+            if(stopped)
+                return 0;
+            if(score >= beta)
+                return score >= SCORE_MATE_IN_MAX_PLY ? beta : score;
+        }
+
+        // Moves are generated in stages, quiet moves only if nothing
+        // before them cuts off
+        MovePicker picker(game, tt_hit ? tt_data.move : PackedMove::none(), killers[ply], history);
+        // Quiet moves searched so far, lowered in history on a cutoff
+        PackedMove quiets[MoveList::CAPACITY];
+        size_t quiet_count = 0;
+
+        int best_score = -SCORE_INFINITE;
+        PackedMove best_move;
+        const int original_alpha = alpha;
+        size_t move_count = 0;
+        Move move = Move::normal(Position{}, Position{});
+        while(picker.next(move)) {
+            const size_t i = move_count++;
+            const auto packed = PackedMove(move);
+            const bool quiet = game.board.at(packed.to_square()).kind() == NONE
+                && !packed.is_promotion()
+                && !packed.is_en_passant();
+
+            game.make_move(move);
+            ++nodes;
+            // Cached, the child node asks again
+            const bool gives_check = game.is_check();
+
+            int score;
+            if(i == 0) {
+                score = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+            }
+            else {
+                // Late quiet moves are searched with reduced depth
+                int reduction = 0;
+                if(depth >= 3 && i >= 3 && quiet && !checked && !gives_check) {
+                    reduction = REDUCTIONS[std::min(depth, 63)][std::min<size_t>(i, 63)];
+                    if(pv_node)
+                        --reduction;
+                    reduction = std::clamp(reduction, 0, depth - 2);
+                }
+
+                // Null window search, re-searched if it beats alpha
+                score = -negamax(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1, true);
+                if(score > alpha && reduction > 0)
+                    score = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1, true);
+                if(score > alpha && score < beta)
+                    score = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+            }
+            game.undo();
+
+            if(stopped)
+                return 0;
+
+            if(score > best_score) {
+                best_score = score;
+                best_move = packed;
+                if(score > alpha) {
+                    alpha = score;
+                    // Update principal variation
+                    pv[ply][ply] = packed;
+                    for(int next = ply + 1; next < pv_length[ply + 1]; ++next)
+                        pv[ply][next] = pv[ply + 1][next];
+                    pv_length[ply] = pv_length[ply + 1];
+                    if(alpha >= beta) {
+                        if(quiet)
+                            update_quiet_stats(packed, quiets, quiet_count, depth, ply);
+                        break;
+                    }
+                }
+            }
+            if(quiet)
+                quiets[quiet_count++] = packed;
+        }
+
+        if(move_count == 0)
+            return checked ? -SCORE_MATE + ply : 0;
+
+        const uint8_t bound = best_score >= beta
+            ? BOUND_LOWER
+            : (alpha > original_alpha ? BOUND_EXACT : BOUND_UPPER);
+        tt.store(key, {
+            best_move,
+            int16_t(score_to_tt(best_score, ply)),
+            int16_t(checked ? 0 : static_eval),
+            uint8_t(depth),
+            bound
+        });
+        return best_score;
+    }
+
+    int Searcher::quiescence(int alpha, int beta, int ply) {
+        pv_length[ply] = ply;
+        if(ply >= MAX_PLY)
+            return game.evaluate();
+        if(should_stop())
+            return 0;
+        const auto tb_score = probe_tablebases(ply);
+        if(tb_score.has_value())
+            return *tb_score;
+
+        // In check every evasion is searched, standing pat could
+        // hide a mate
+        const bool checked = game.is_check();
+        int best_score = -SCORE_INFINITE;
+        if(!checked) {
+            // The side to move isn't forced to capture
+            best_score = game.evaluate();
+            if(best_score >= beta)
+                return best_score;
+            alpha = std::max(alpha, best_score);
+        }
+
+        // Losing captures are pruned, told apart by SEE
+        MovePicker picker = checked
+            ? MovePicker(game, PackedMove::none(), Killers{}, history)
+            : MovePicker(game, history);
+        size_t move_count = 0;
+        Move move = Move::normal(Position{}, Position{});
+        while(picker.next(move)) {
+            ++move_count;
+            game.make_move(move);
+            ++nodes;
+            const int score = -quiescence(-beta, -alpha, ply + 1);
+            game.undo();
+
+            if(stopped)
+                return 0;
+
+            if(score > best_score) {
+                best_score = score;
+                if(score > alpha) {
+                    alpha = score;
+                    if(alpha >= beta)
+                        break;
+                }
+            }
+        }
+
+        if(checked && move_count == 0)
+            return -SCORE_MATE + ply;
+        return best_score;
+    }
+
+    void Searcher::update_quiet_stats(
+        PackedMove best,
+        const PackedMove* tried,
+        size_t tried_count,
+        int depth,
+        int ply)
+    {
+        if(killers[ply][0] != best) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = best;
+        }
+        const Color us = game.turn();
+        const int bonus = depth * depth;
+        history.update(us, best, bonus);
+        for(size_t i = 0; i < tried_count; ++i)
+            history.update(us, tried[i], -bonus);
+    }
+
+    SearchResult Searcher::result(int score, int depth) {
+        SearchResult res;
+        res.score = score;
+        res.depth = depth;
+        res.nodes = nodes;
+        res.time = elapsed();
+
+        // Principal variation is replayed to unpack its moves
+        for(int i = 0; i < pv_length[0]; ++i) {
+            const auto move = pv[0][i].to_move(game.board);
+            res.pv.push_back(move);
+            game.make_move(move);
+        }
+        for(size_t i = 0; i < res.pv.size(); ++i)
+            game.undo();
+
+        if(!res.pv.empty())
+            res.best_move = res.pv.front();
+        return res;
+    }
+
+    SearchResult Searcher::iterate(const SearchCallback& on_iteration) {
+        SearchResult best;
+        // Any legal move, in case not even depth 1 completes
+        const auto root_moves = game.legal_moves();
+        if(!root_moves.empty())
+            best.best_move = root_moves[0];
+        else
+            return best;
+
+        int score = 0;
+        for(int depth = 1; depth <= limits.depth && depth < MAX_PLY; ++depth) {
+            if(skip_depth(depth))
+                continue;
+
+            // Aspiration window around the previous score, widened
+            // on fail low or fail high
+            int delta = 25;
+            int alpha = -SCORE_INFINITE;
+            int beta = SCORE_INFINITE;
+            if(depth >= 5) {
+                alpha = std::max(score - delta, -SCORE_INFINITE);
+                beta = std::min(score + delta, SCORE_INFINITE);
+            }
+
+            while(true) {
+                const int iteration_score = negamax(alpha, beta, depth, 0, true);
+                if(stopped)
+                    break;
+                if(iteration_score <= alpha) {
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(iteration_score - delta, -SCORE_INFINITE);
+                }
+                else if(iteration_score >= beta) {
+                    beta = std::min(iteration_score + delta, SCORE_INFINITE);
+                }
+                else {
+                    score = iteration_score;
+                    break;
+                }
+                delta *= 2;
+            }
+            if(stopped)
+                break;
+
+            best = result(score, depth);
+            if(on_iteration && id == 0) {
+                best.nodes = total_nodes();
+                on_iteration(best);
+            }
+            // Mate found, deeper iterations can't improve it
+            if(std::abs(score) >= SCORE_MATE_IN_MAX_PLY
+                && SCORE_MATE - std::abs(score) <= depth)
+            {
+                break;
+            }
+        }
+        best.time = elapsed();
+        return best;
+    }
+}
+
+namespace lc {
+    SearchResult search(
+        const ChessGame& game,
+        TranspositionTable& tt,
+        const SearchLimits& limits,
+        const std::atomic<bool>& stop,
+        const SearchCallback& on_iteration)
+    {
+        tt.new_search();
+        SharedState shared{limits, stop, false, 0, Clock::now()};
+
+        // Each searcher owns a copy of the game and its PV table,
+        // too big for the stack
+        const unsigned threads = std::max(1u, limits.threads);
+        std::vector<std::unique_ptr<Searcher>> searchers;
+        for(unsigned id = 0; id < threads; ++id)
+            searchers.push_back(std::make_unique<Searcher>(game, tt, shared, id));
+
+        std::vector<SearchResult> results(threads);
+        std::vector<std::thread> helpers;
+        for(unsigned id = 1; id < threads; ++id) {
+            helpers.emplace_back([&, id]() {
+                results[id] = searchers[id]->iterate({});
+            });
+        }
+        results[0] = searchers[0]->iterate(on_iteration);
+        shared.done = true;
+        for(auto& helper : helpers)
+            helper.join();
+
+        // Deepest completed iteration wins, main thread on ties
+        size_t best = 0;
+        uint64_t nodes = 0;
+        for(size_t i = 0; i < threads; ++i) {
+            nodes += searchers[i]->own_nodes();
+            if(results[i].depth > results[best].depth && results[i].best_move.has_value())
+                best = i;
+        }
+        auto result = std::move(results[best]);
+        result.nodes = nodes;
+        return result;
+    }
+}
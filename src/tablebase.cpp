@@ -0,0 +1,817 @@
+#include "tablebase.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+static_assert(std::endian::native == std::endian::little, "Tables are little endian");
+
+namespace {
+    using namespace lc;
+    using namespace lc::tablebase;
+
+    constexpr char TABLE_MAGIC[8] = { 'L', 'C', 'T', 'B', 'A', 'S', 'E', 'S' };
+    constexpr uint32_t TABLE_VERSION = 1;
+
+    struct TableHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        // Set name, zero padded
+        char     name[16];
+        uint64_t entry_count;
+        uint64_t wdl_offset;
+        uint64_t dtm_offset;
+        uint64_t padding;
+    };
+    static_assert(sizeof(TableHeader) == 64);
+
+    // Distance to mate codes, also the generator position states
+    constexpr uint8_t DTM_DRAW = 0;
+    constexpr uint8_t DTM_UNREACHABLE = 255;
+    constexpr int MAX_DTM = 253;
+    constexpr uint8_t WDL_UNREACHABLE = 3;
+
+    constexpr uint8_t dtm_code(int plies) { return uint8_t(plies + 1); }
+
+    // No castling right left
+    constexpr uint8_t NO_CASTLING = CASTLING_STATE_MASK;
+
+    // Kinds in set names, strongest first
+    constexpr char PIECE_LETTERS[] = "QRBNP";
+
+    constexpr uint8_t letter_kind(char letter) {
+        switch(letter) {
+            case 'Q': return QUEEN;
+            case 'R': return ROOK;
+            case 'B': return BISHOP;
+            case 'N': return KNIGHT;
+            case 'P': return PAWN;
+        }
+        return NONE;
+    }
+
+    constexpr char kind_letter(uint8_t kind) {
+        return PIECE_LETTERS[QUEEN - kind];
+    }
+
+    // Pieces of a side besides the king as letters, strongest first.
+    // A side is stronger with more pieces, or else with the stronger
+    // first different one
+    bool stronger(const std::string& a, const std::string& b) {
+        if(a.size() != b.size())
+            return a.size() > b.size();
+        for(size_t i = 0; i < a.size(); ++i)
+            if(a[i] != b[i])
+                return letter_kind(a[i]) > letter_kind(b[i]);
+        return false;
+    }
+
+    std::string set_name(const std::string& white, const std::string& black) {
+        return stronger(black, white)
+            ? "K" + black + "vK" + white
+            : "K" + white + "vK" + black;
+    }
+
+    // Symmetries applied to the squares of a position, so the white
+    // king lands on one of the indexed squares
+    constexpr uint8_t MIRROR_FILE = 1;
+    constexpr uint8_t MIRROR_RANK = 2;
+    constexpr uint8_t TRANSPOSE = 4;
+
+    constexpr Square transform(Square sq, uint8_t symmetry) {
+        if(symmetry & MIRROR_FILE)
+            sq = Square(sq ^ 7);
+        if(symmetry & MIRROR_RANK)
+            sq = Square(sq ^ 56);
+        if(symmetry & TRANSPOSE)
+            sq = Square(((sq & 7) << 3) | (sq >> 3));
+        return sq;
+    }
+
+    // Pawns only allow mirroring files, without them the king is
+    // brought to the a8-d8-d5 triangle
+    constexpr uint8_t king_symmetry(Square king, bool pawns) {
+        uint8_t x = king % 8;
+        uint8_t y = king / 8;
+        uint8_t symmetry = 0;
+        if(x > 3) {
+            symmetry |= MIRROR_FILE;
+            x = uint8_t(7 - x);
+        }
+        if(pawns)
+            return symmetry;
+        if(y > 3) {
+            symmetry |= MIRROR_RANK;
+            y = uint8_t(7 - y);
+        }
+        if(y > x)
+            symmetry |= TRANSPOSE;
+        return symmetry;
+    }
+
+    // Indexed white king squares
+    struct KingSlots {
+        std::array<Square,64>  squares = {};
+        std::array<uint8_t,64> slot = {};
+        uint8_t                count = 0;
+    };
+
+    constexpr KingSlots king_slots(bool pawns) {
+        KingSlots slots;
+        for(uint8_t sq = 0; sq < 64; ++sq) {
+            if(king_symmetry(Square(sq), pawns) == 0) {
+                slots.slot[sq] = slots.count;
+                slots.squares[slots.count++] = Square(sq);
+            }
+        }
+        return slots;
+    }
+
+    constexpr KingSlots PAWNLESS_KINGS = king_slots(false);
+    constexpr KingSlots PAWN_KINGS = king_slots(true);
+    static_assert(PAWNLESS_KINGS.count == 10 && PAWN_KINGS.count == 32);
+
+    constexpr uint32_t key_unit(Color c, uint8_t kind) {
+        return uint32_t(1) << (3 * (color_index(c) * 5 + kind - PAWN));
+    }
+
+    // Piece counts of both colors, 3 bits each. Colors are swapped
+    // if 'flip'
+    uint32_t material_key(const Board& board, bool flip) {
+        uint32_t key = 0;
+        for(uint8_t kind = PAWN; kind <= QUEEN; ++kind) {
+            key += uint32_t(popcount(board.pieces(WHITE, kind))) * key_unit(flip ? BLACK : WHITE, kind);
+            key += uint32_t(popcount(board.pieces(BLACK, kind))) * key_unit(flip ? WHITE : BLACK, kind);
+        }
+        return key;
+    }
+
+    uint32_t material_key(const Layout& layout) {
+        uint32_t key = 0;
+        for(const auto piece : layout.pieces)
+            if(piece.kind() != KING)
+                key += key_unit(piece.color(), piece.kind());
+        return key;
+    }
+
+    // Square skipped by a pawn of the side not to move that may just
+    // have moved two squares, next to a pawn of 'us'. NO_SQUARE if
+    // there's none, sets of at most 4 pieces have a single candidate
+    Square double_move_square(const Board& board, Color us) {
+        const Color them = us ^ BLACK;
+        const uint8_t row = them == WHITE ? 4 : 3;
+        const int back = them == WHITE ? 8 : -8;
+        for(auto pawns = board.pieces(them, PAWN); pawns;) {
+            const auto pawn = pop_lsb(pawns);
+            if(pawn / 8 != row)
+                continue;
+            const auto skipped = Square(pawn + back);
+            const auto origin = Square(pawn + 2 * back);
+            if(board.at(skipped).kind() == NONE && board.at(origin).kind() == NONE
+                && (pawn_attacks[color_index(them)][skipped] & board.pieces(us, PAWN)))
+            {
+                return skipped;
+            }
+        }
+        return NO_SQUARE;
+    }
+
+    // Same pieces in increasing square order
+    void sort_groups(const Layout& layout, Square* squares) {
+        for(size_t i = 1; i < layout.pieces.size(); ++i) {
+            for(size_t j = i; j > 0 && layout.pieces[j].raw() == layout.pieces[j - 1].raw()
+                && squares[j] < squares[j - 1]; --j)
+            {
+                std::swap(squares[j], squares[j - 1]);
+            }
+        }
+    }
+
+    // With the white king on the a8-h1 diagonal a position and its
+    // transpose are both in the triangle, only the one of smaller
+    // index is kept. True if it's the transpose, written to 'transposed'
+    bool prefer_transpose(const Layout& layout, const Square* squares, Square* transposed) {
+        const size_t count = layout.pieces.size();
+        if(layout.pawns || squares[0] % 8 != squares[0] / 8)
+            return false;
+        for(size_t i = 0; i < count; ++i)
+            transposed[i] = transform(squares[i], TRANSPOSE);
+        sort_groups(layout, transposed);
+        return std::lexicographical_compare(transposed, transposed + count, squares, squares + count);
+    }
+
+    // Index of a position of the set of 'layout', with colors swapped
+    // and the board mirrored if 'flip'
+    uint64_t encode(const Layout& layout, const Board& board, Color us, Square en_passant, bool flip) {
+        const size_t count = layout.pieces.size();
+        Square squares[MAX_PIECES];
+        // Pieces of the current kind and color not placed yet
+        Bitboard group = 0;
+        for(size_t i = 0; i < count; ++i) {
+            const auto piece = layout.pieces[i];
+            if(i == 0 || piece.raw() != layout.pieces[i - 1].raw())
+                group = board.pieces(flip ? piece.color() ^ BLACK : piece.color(), piece.kind());
+            squares[i] = Square(pop_lsb(group) ^ (flip ? 56 : 0));
+        }
+
+        const auto symmetry = king_symmetry(squares[0], layout.pawns);
+        for(size_t i = 0; i < count; ++i)
+            squares[i] = transform(squares[i], symmetry);
+        sort_groups(layout, squares);
+        Square transposed[MAX_PIECES];
+        if(prefer_transpose(layout, squares, transposed))
+            std::copy(transposed, transposed + count, squares);
+
+        const auto& kings = layout.pawns ? PAWN_KINGS : PAWNLESS_KINGS;
+        uint64_t index = (us == WHITE) != flip ? 0 : 1;
+        if(layout.en_passant)
+            index = index * 2 + (en_passant != NO_SQUARE ? 1 : 0);
+        index = index * kings.count + kings.slot[squares[0]];
+        for(size_t i = 1; i < count; ++i)
+            index = index * 64 + squares[i];
+        return index;
+    }
+
+    struct Decoded {
+        Board  board;
+        Color  us;
+        Square en_passant;
+    };
+
+    // Position at 'index', std::nullopt if it can't be reached: pieces
+    // on the same square or out of order, the transpose of a position
+    // of smaller index, pawns on the last ranks, the
+    // side not to move in check or an en passant flag without a pawn
+    // that could have just moved two squares
+    std::optional<Decoded> decode(const Layout& layout, uint64_t index) {
+        const size_t count = layout.pieces.size();
+        Square squares[MAX_PIECES];
+        for(size_t i = count; i-- > 1;) {
+            squares[i] = Square(index % 64);
+            index /= 64;
+        }
+        const auto& kings = layout.pawns ? PAWN_KINGS : PAWNLESS_KINGS;
+        squares[0] = kings.squares[index % kings.count];
+        index /= kings.count;
+        bool en_passant_flag = false;
+        if(layout.en_passant) {
+            en_passant_flag = index % 2;
+            index /= 2;
+        }
+        const Color us = index ? BLACK : WHITE;
+
+        Decoded decoded = { Board::empty(), us, NO_SQUARE };
+        auto& board = decoded.board;
+        for(size_t i = 0; i < count; ++i) {
+            const auto piece = layout.pieces[i];
+            const auto sq = squares[i];
+            if(board.at(sq).kind() != NONE)
+                return std::nullopt;
+            if(i > 0 && piece.raw() == layout.pieces[i - 1].raw() && sq < squares[i - 1])
+                return std::nullopt;
+            if(piece.kind() == PAWN && (sq < 8 || sq >= 56))
+                return std::nullopt;
+            board.set(position_of(sq), piece);
+        }
+        Square transposed[MAX_PIECES];
+        if(prefer_transpose(layout, squares, transposed))
+            return std::nullopt;
+
+        const auto their_king = lsb(board.pieces(us ^ BLACK, KING));
+        if(board.attackers_to(their_king, board.occupancy()) & board.pieces(us))
+            return std::nullopt;
+        if(en_passant_flag) {
+            decoded.en_passant = double_move_square(board, us);
+            if(decoded.en_passant == NO_SQUARE)
+                return std::nullopt;
+        }
+        return decoded;
+    }
+
+    bool can_castle(uint8_t state) {
+        // A right stays while neither the king nor that rook moved
+        constexpr uint8_t rights[4] = {
+            WHITE_KING_MOVED_BIT | WHITE_KINGSIDE_ROOK_MOVED_BIT,
+            WHITE_KING_MOVED_BIT | WHITE_QUEENSIDE_ROOK_MOVED_BIT,
+            BLACK_KING_MOVED_BIT | BLACK_KINGSIDE_ROOK_MOVED_BIT,
+            BLACK_KING_MOVED_BIT | BLACK_QUEENSIDE_ROOK_MOVED_BIT
+        };
+        for(const auto right : rights)
+            if(!(state & right))
+                return true;
+        return false;
+    }
+
+    std::optional<ProbeResult> dtm_result(uint8_t code) {
+        if(code == DTM_UNREACHABLE)
+            return std::nullopt;
+        if(code == DTM_DRAW)
+            return ProbeResult{ Wdl::Draw, 0 };
+        const int plies = code - 1;
+        return ProbeResult{ plies % 2 ? Wdl::Win : Wdl::Loss, plies };
+    }
+
+    // Positions handed to each task of a pass
+    constexpr uint64_t CHUNK_SIZE = 1 << 14;
+
+    // Retrograde analysis of a set. Positions are solved in passes of
+    // increasing distance to mate: pass 'n' takes every position
+    // mated or mating in 'n' plies and walks the moves leading to it
+    // backwards. A predecessor of a lost position wins in 'n + 1', one
+    // of a won position loses once all its moves are known to lose.
+    // Captures and promotions leave the set, their outcome is probed
+    // up front in the smaller tables. Positions left unsolved are draws
+    class Generator {
+        private:
+        const Layout&        layout;
+        const Tablebases&    tables;
+        ThreadPool&          pool;
+        // Distance to mate codes, 'DTM_DRAW' until solved
+        std::vector<uint8_t> values;
+        // Moves to distinct positions of the set not known to lose
+        // yet, 'CANNOT_LOSE' if a capture or promotion doesn't lose
+        std::vector<uint8_t> counters;
+        // Plies to mate through the best capture or promotion: the
+        // fastest win if it's one, the slowest loss otherwise. 0 for
+        // none
+        std::vector<uint8_t> exits;
+        // Deepest distance solved or scheduled so far
+        std::atomic<int>     horizon;
+        // A table is missing or distances don't fit
+        std::atomic<bool>    failed;
+
+        static constexpr uint8_t CANNOT_LOSE = 255;
+
+        public:
+        Generator(const Layout& _layout, const Tablebases& _tables, ThreadPool& _pool)
+            : layout(_layout)
+            , tables(_tables)
+            , pool(_pool)
+            , values(_layout.size, DTM_DRAW)
+            , counters(_layout.size, 0)
+            , exits(_layout.size, 0)
+            , horizon(0)
+            , failed(false) {}
+
+        // False if a table is missing or a distance doesn't fit
+        bool run() {
+            const size_t tasks = size_t((layout.size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+            pool.run(tasks, [&](size_t task) { initialize(task); });
+            for(int plies = 0; plies <= horizon.load() && !failed.load(); ++plies)
+                pool.run(tasks, [&](size_t task) { step(task, plies); });
+            return !failed.load();
+        }
+
+        const std::vector<uint8_t>& result() const { return values; }
+
+        private:
+        std::pair<uint64_t,uint64_t> range(size_t task) const {
+            const uint64_t first = task * CHUNK_SIZE;
+            return { first, std::min(first + CHUNK_SIZE, layout.size) };
+        }
+
+        void extend_horizon(int plies) {
+            if(plies > MAX_DTM) {
+                failed = true;
+                return;
+            }
+            int current = horizon.load(std::memory_order_relaxed);
+            while(current < plies && !horizon.compare_exchange_weak(current, plies));
+        }
+
+        // Mates, stalemates, unreachable positions and the outcome of
+        // the moves leaving the set
+        void initialize(size_t task) {
+            const auto [first, last] = range(task);
+            MoveList moves;
+            uint64_t children[MoveList::CAPACITY];
+            for(uint64_t index = first; index < last; ++index) {
+                const auto position = decode(layout, index);
+                if(!position.has_value()) {
+                    values[index] = DTM_UNREACHABLE;
+                    continue;
+                }
+                const auto& board = position->board;
+                const Color us = position->us;
+                const Color them = us ^ BLACK;
+
+                moves.clear();
+                generate_legal_moves(board, us, NO_CASTLING, position->en_passant, moves);
+                if(moves.empty()) {
+                    const auto king = lsb(board.pieces(us, KING));
+                    if(board.attackers_to(king, board.occupancy()) & board.pieces(them))
+                        values[index] = dtm_code(0);
+                    counters[index] = CANNOT_LOSE;
+                    continue;
+                }
+
+                size_t child_count = 0;
+                int exit_win = 0;
+                int exit_loss = 0;
+                bool exit_draw = false;
+                for(const auto& move : moves) {
+                    auto child = board;
+                    uint8_t state = NO_CASTLING;
+                    Square en_passant = NO_SQUARE;
+                    apply_board_move(child, move, state, en_passant);
+                    if(popcount(child.occupancy()) == popcount(board.occupancy())
+                        && popcount(child.kind_bb[PAWN]) == popcount(board.kind_bb[PAWN]))
+                    {
+                        children[child_count++] = encode(layout, child, them, en_passant, false);
+                        continue;
+                    }
+
+                    const auto outcome = tables.probe(child, them, en_passant);
+                    if(!outcome.has_value()) {
+                        failed = true;
+                        return;
+                    }
+                    if(outcome->wdl == Wdl::Loss)
+                        exit_win = exit_win ? std::min(exit_win, outcome->dtm + 1) : outcome->dtm + 1;
+                    else if(outcome->wdl == Wdl::Win)
+                        exit_loss = std::max(exit_loss, outcome->dtm + 1);
+                    else
+                        exit_draw = true;
+                }
+
+                if(exit_win || exit_draw) {
+                    counters[index] = CANNOT_LOSE;
+                    exits[index] = uint8_t(std::min(exit_win, MAX_DTM + 1));
+                    extend_horizon(exit_win);
+                    continue;
+                }
+                // Symmetric moves may lead to the same index, counted once
+                // as each solved position is walked back from once
+                std::sort(children, children + child_count);
+                const auto distinct = size_t(std::unique(children, children + child_count) - children);
+                counters[index] = uint8_t(distinct);
+                exits[index] = uint8_t(std::min(exit_loss, MAX_DTM + 1));
+                if(distinct == 0) {
+                    values[index] = dtm_code(std::min(exit_loss, MAX_DTM));
+                    extend_horizon(exit_loss);
+                }
+            }
+        }
+
+        // Solves the predecessors of the positions at 'plies' from mate
+        void step(size_t task, int plies) {
+            const auto [first, last] = range(task);
+            const uint8_t code = dtm_code(plies);
+            const uint8_t next_code = dtm_code(std::min(plies + 1, MAX_DTM));
+            uint64_t parents[256];
+            for(uint64_t index = first; index < last; ++index) {
+                std::atomic_ref value(values[index]);
+                const auto current = value.load(std::memory_order_relaxed);
+                if(current == DTM_DRAW) {
+                    // Winning capture or promotion, unless a faster win
+                    // was found since
+                    std::atomic_ref counter(counters[index]);
+                    if(counter.load(std::memory_order_relaxed) == CANNOT_LOSE && exits[index] == plies + 1) {
+                        uint8_t expected = DTM_DRAW;
+                        value.compare_exchange_strong(expected, next_code, std::memory_order_relaxed);
+                    }
+                    continue;
+                }
+                if(current != code)
+                    continue;
+
+                const auto position = decode(layout, index);
+                const auto parent_count = predecessors(*position, parents);
+                const bool lost = plies % 2 == 0;
+                for(size_t i = 0; i < parent_count; ++i) {
+                    const auto parent = parents[i];
+                    std::atomic_ref parent_value(values[parent]);
+                    if(parent_value.load(std::memory_order_relaxed) == DTM_UNREACHABLE)
+                        continue;
+                    if(lost) {
+                        uint8_t expected = DTM_DRAW;
+                        if(parent_value.compare_exchange_strong(expected, next_code, std::memory_order_relaxed))
+                            extend_horizon(plies + 1);
+                        continue;
+                    }
+                    // Positions with a move to a lost one can't run out
+                    // of moves, the counter never reaches 0
+                    std::atomic_ref counter(counters[parent]);
+                    if(counter.load(std::memory_order_relaxed) == CANNOT_LOSE)
+                        continue;
+                    if(counter.fetch_sub(1, std::memory_order_relaxed) == 1) {
+                        const int loss = std::max(plies + 1, int(exits[parent]));
+                        parent_value.store(dtm_code(std::min(loss, MAX_DTM)), std::memory_order_relaxed);
+                        extend_horizon(loss);
+                    }
+                }
+            }
+        }
+
+        // Distinct indices of the positions of the set with a move to
+        // 'position' that neither captures nor promotes. Unreachable
+        // ones may be among them
+        size_t predecessors(const Decoded& position, uint64_t* parents) const {
+            const auto& board = position.board;
+            // Side that made the move
+            const Color them = position.us ^ BLACK;
+            const auto occupancy = board.occupancy();
+            const auto empty = ~occupancy;
+            const int back = them == WHITE ? 8 : -8;
+            size_t count = 0;
+
+            const auto add = [&](Square from, Square to) {
+                auto parent = board;
+                parent.set(position_of(from), parent.at(to));
+                parent.set(position_of(to), NONE);
+                parents[count++] = encode(layout, parent, them, NO_SQUARE, false);
+                // The position before may have allowed an en passant capture
+                if(layout.en_passant) {
+                    const auto en_passant = double_move_square(parent, them);
+                    if(en_passant != NO_SQUARE)
+                        parents[count++] = encode(layout, parent, them, en_passant, false);
+                }
+            };
+
+            if(position.en_passant != NO_SQUARE) {
+                // Only reached by the pawn double move
+                const auto to = Square(position.en_passant - back);
+                add(Square(to + 2 * back), to);
+            }
+            else {
+                for(auto pieces = board.pieces(them); pieces;) {
+                    const auto to = pop_lsb(pieces);
+                    Bitboard from = 0;
+                    switch(board.at(to).kind()) {
+                        case PAWN: {
+                            const uint8_t row = to / 8;
+                            const auto behind = Square(to + back);
+                            // Not from the first rank
+                            if(board.at(behind).kind() != NONE || (them == WHITE ? row == 6 : row == 1))
+                                break;
+                            from |= square_bb(behind);
+                            // A double move next to an enemy pawn leads to
+                            // the position with the en passant flag
+                            const auto origin = Square(to + 2 * back);
+                            if((them == WHITE ? row == 4 : row == 3)
+                                && board.at(origin).kind() == NONE
+                                && !(pawn_attacks[color_index(them)][behind] & board.pieces(position.us, PAWN)))
+                            {
+                                from |= square_bb(origin);
+                            }
+                            break;
+                        }
+                        case KNIGHT: from = knight_attacks[to]; break;
+                        case BISHOP: from = bishop_attacks(to, occupancy); break;
+                        case ROOK:   from = rook_attacks(to, occupancy); break;
+                        case QUEEN:  from = queen_attacks(to, occupancy); break;
+                        case KING:   from = king_attacks[to]; break;
+                    }
+                    for(from &= empty; from;)
+                        add(pop_lsb(from), to);
+                }
+            }
+
+            std::sort(parents, parents + count);
+            return size_t(std::unique(parents, parents + count) - parents);
+        }
+    };
+
+    bool write_table(
+        const std::string& path,
+        const std::string& name,
+        const std::vector<uint8_t>& values)
+    {
+        std::vector<uint8_t> wdl((values.size() + 3) / 4, 0);
+        for(size_t i = 0; i < values.size(); ++i) {
+            const auto result = dtm_result(values[i]);
+            const uint8_t bits = result.has_value() ? uint8_t(result->wdl) : WDL_UNREACHABLE;
+            wdl[i / 4] |= uint8_t(bits << (2 * (i % 4)));
+        }
+
+        TableHeader header = {};
+        std::memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+        header.version = TABLE_VERSION;
+        std::memcpy(header.name, name.data(), std::min(name.size(), sizeof(header.name)));
+        header.entry_count = values.size();
+        header.wdl_offset = sizeof(TableHeader);
+        header.dtm_offset = (header.wdl_offset + wdl.size() + 7) & ~uint64_t(7);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file)
+            return false;
+        static const char zeros[8] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(wdl.data()), std::streamsize(wdl.size()));
+        file.write(zeros, std::streamsize(header.dtm_offset - header.wdl_offset - wdl.size()));
+        file.write(reinterpret_cast<const char*>(values.data()), std::streamsize(values.size()));
+        return bool(file);
+    }
+}
+
+namespace lc::tablebase {
+    std::optional<Layout> layout(const std::string& name) {
+        const auto split = name.find('v');
+        if(split == std::string::npos || name.size() - 1 > MAX_PIECES
+            || name[0] != 'K' || split + 1 >= name.size() || name[split + 1] != 'K')
+        {
+            return std::nullopt;
+        }
+        const auto white = name.substr(1, split - 1);
+        const auto black = name.substr(split + 2);
+        if(white.empty() || stronger(black, white))
+            return std::nullopt;
+
+        Layout result;
+        result.pieces = { king(WHITE), king(BLACK) };
+        bool pawns[2] = { false, false };
+        for(const auto& [side, c] : { std::pair{ white, WHITE }, std::pair{ black, BLACK } }) {
+            for(size_t i = 0; i < side.size(); ++i) {
+                const auto kind = letter_kind(side[i]);
+                // Strongest first, so the name is unique
+                if(kind == NONE || (i > 0 && kind > letter_kind(side[i - 1])))
+                    return std::nullopt;
+                result.pieces.push_back(Piece(kind | c));
+                pawns[color_index(c)] |= kind == PAWN;
+            }
+        }
+        result.pawns = pawns[0] || pawns[1];
+        result.en_passant = pawns[0] && pawns[1];
+
+        const auto& kings = result.pawns ? PAWN_KINGS : PAWNLESS_KINGS;
+        result.size = 2 * (result.en_passant ? 2 : 1) * kings.count;
+        for(size_t i = 1; i < result.pieces.size(); ++i)
+            result.size *= 64;
+        return result;
+    }
+
+    std::string material_name(const Board& board) {
+        std::string sides[2];
+        for(uint8_t kind = QUEEN; kind >= PAWN; --kind) {
+            sides[0].append(size_t(popcount(board.pieces(WHITE, kind))), kind_letter(kind));
+            sides[1].append(size_t(popcount(board.pieces(BLACK, kind))), kind_letter(kind));
+        }
+        return set_name(sides[0], sides[1]);
+    }
+
+    std::vector<std::string> table_names(size_t pieces) {
+        pieces = std::min(pieces, MAX_PIECES);
+        // Every side of up to 'pieces - 3' pieces besides the king
+        std::vector<std::string> sides = { "" };
+        for(size_t i = 0; i < sides.size(); ++i) {
+            if(sides[i].size() + 3 > pieces)
+                continue;
+            for(const char* letter = PIECE_LETTERS; *letter; ++letter)
+                if(sides[i].empty() || letter_kind(*letter) <= letter_kind(sides[i].back()))
+                    sides.push_back(sides[i] + *letter);
+        }
+
+        std::vector<std::string> names;
+        for(const auto& white : sides) {
+            for(const auto& black : sides) {
+                if(white.size() + black.size() + 2 > pieces || white.empty() || stronger(black, white))
+                    continue;
+                names.push_back(set_name(white, black));
+            }
+        }
+        // Captures lower the piece count and promotions the pawn count
+        const auto order = [](const std::string& name) {
+            return std::pair{ name.size(), std::count(name.begin(), name.end(), 'P') };
+        };
+        std::stable_sort(names.begin(), names.end(), [&](const std::string& a, const std::string& b) {
+            return order(a) < order(b);
+        });
+        return names;
+    }
+
+    Tablebases::Tablebases()
+        : largest(0) {}
+
+    size_t Tablebases::open(const std::string& directory) {
+        size_t count = 0;
+        for(const auto& name : table_names())
+            count += add(directory + "/" + name + ".lctb") ? 1 : 0;
+        return count;
+    }
+
+    bool Tablebases::add(const std::string& path) {
+        MappedFile file;
+        if(!file.open(path))
+            return false;
+
+        // Both sections must lie inside the file
+        TableHeader header;
+        const auto size = file.size();
+        if(size < sizeof(header))
+            return false;
+        std::memcpy(&header, file.data(), sizeof(header));
+        const auto name = std::string(header.name, strnlen(header.name, sizeof(header.name)));
+        const auto table_layout = layout(name);
+        const auto fits = [&](uint64_t offset, uint64_t length) {
+            return offset <= size && length <= size - offset;
+        };
+        if(std::memcmp(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0
+            || header.version != TABLE_VERSION
+            || !table_layout.has_value()
+            || header.entry_count != table_layout->size
+            || !fits(header.wdl_offset, (header.entry_count + 3) / 4)
+            || !fits(header.dtm_offset, header.entry_count))
+        {
+            return false;
+        }
+
+        const auto key = material_key(*table_layout);
+        auto& table = tables[key];
+        table.file = std::move(file);
+        table.layout = std::move(*table_layout);
+        table.wdl = reinterpret_cast<const uint8_t*>(table.file.data() + header.wdl_offset);
+        table.dtm = reinterpret_cast<const uint8_t*>(table.file.data() + header.dtm_offset);
+        largest = std::max(largest, table.layout.pieces.size());
+        return true;
+    }
+
+    void Tablebases::close() {
+        tables.clear();
+        largest = 0;
+    }
+
+    std::pair<const Tablebases::Table*,uint64_t> Tablebases::find(
+        const Board& board,
+        Color us,
+        Square en_passant) const
+    {
+        if(size_t(popcount(board.occupancy())) > largest)
+            return { nullptr, 0 };
+        // Sets are stored with white the stronger side, positions
+        // with the pieces of black are flipped
+        bool flip = false;
+        auto it = tables.find(material_key(board, false));
+        if(it == tables.end()) {
+            flip = true;
+            it = tables.find(material_key(board, true));
+            if(it == tables.end())
+                return { nullptr, 0 };
+        }
+        const auto& table = it->second;
+        return { &table, encode(table.layout, board, us, en_passant, flip) };
+    }
+
+    std::optional<ProbeResult> Tablebases::probe(const Board& board, Color us, Square en_passant) const {
+        if(popcount(board.occupancy()) == 2)
+            return ProbeResult{ Wdl::Draw, 0 };
+        const auto [table, index] = find(board, us, en_passant);
+        if(table == nullptr)
+            return std::nullopt;
+        return dtm_result(table->dtm[index]);
+    }
+
+    std::optional<ProbeResult> Tablebases::probe(const ChessGame& game) const {
+        if(can_castle(game.castling_state()))
+            return std::nullopt;
+        return probe(game.board, game.turn(), game.en_passant_square());
+    }
+
+    std::optional<Wdl> Tablebases::probe_wdl(const ChessGame& game) const {
+        if(can_castle(game.castling_state()))
+            return std::nullopt;
+        if(popcount(game.board.occupancy()) == 2)
+            return Wdl::Draw;
+        const auto [table, index] = find(game.board, game.turn(), game.en_passant_square());
+        if(table == nullptr)
+            return std::nullopt;
+        const uint8_t bits = (table->wdl[index / 4] >> (2 * (index % 4))) & 0b11;
+        if(bits == WDL_UNREACHABLE)
+            return std::nullopt;
+        return Wdl(bits);
+    }
+
+    std::optional<GenerateStats> generate(
+        const std::string& name,
+        const Tablebases& tables,
+        ThreadPool& pool,
+        const std::string& path)
+    {
+        const auto table_layout = layout(name);
+        if(!table_layout.has_value())
+            return std::nullopt;
+        Generator generator(*table_layout, tables, pool);
+        if(!generator.run())
+            return std::nullopt;
+
+        const auto& values = generator.result();
+        GenerateStats stats;
+        for(const auto code : values) {
+            const auto result = dtm_result(code);
+            if(!result.has_value())
+                continue;
+            ++stats.positions;
+            switch(result->wdl) {
+                case Wdl::Win:  ++stats.wins; break;
+                case Wdl::Draw: ++stats.draws; break;
+                case Wdl::Loss: ++stats.losses; break;
+            }
+            stats.longest_mate = std::max(stats.longest_mate, result->dtm);
+        }
+        if(!write_table(path, name, values))
+            return std::nullopt;
+        return stats;
+    }
+}
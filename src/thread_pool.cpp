@@ -0,0 +1,79 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace lc {
+    ThreadPool::ThreadPool(unsigned threads)
+        : job(nullptr)
+        , task_count(0)
+        , generation(0)
+        , active(0)
+        , quit(false)
+        , next_task(0)
+    {
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned i = 1; i < threads; ++i)
+            workers.emplace_back(&ThreadPool::work, this);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            quit = true;
+        }
+        start_cv.notify_all();
+        for(auto& worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::run(size_t tasks, const std::function<void(size_t)>& f) {
+        // Not worth waking anyone
+        if(tasks <= 1 || workers.empty()) {
+            for(size_t i = 0; i < tasks; ++i)
+                f(i);
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            job = &f;
+            task_count = tasks;
+            next_task = 0;
+            active = workers.size();
+            ++generation;
+        }
+        start_cv.notify_all();
+
+        for(size_t i = next_task++; i < tasks; i = next_task++)
+            f(i);
+
+        std::unique_lock lock(mutex);
+        done_cv.wait(lock, [this]() { return active == 0; });
+        job = nullptr;
+    }
+
+    void ThreadPool::work() {
+        uint64_t seen = 0;
+        while(true) {
+            const std::function<void(size_t)>* current;
+            size_t tasks;
+            {
+                std::unique_lock lock(mutex);
+                start_cv.wait(lock, [&]() { return quit || generation != seen; });
+                if(quit)
+                    return;
+                seen = generation;
+                current = job;
+                tasks = task_count;
+            }
+
+            for(size_t i = next_task++; i < tasks; i = next_task++)
+                (*current)(i);
+
+            std::lock_guard lock(mutex);
+            if(--active == 0)
+                done_cv.notify_one();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "trace.hpp"
+
+#if LC_TRACE_ENABLED
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace {
+    using lc::trace::Counters;
+    using lc::trace::detail::LocalCounters;
+
+    // Counters of live threads, and the sums of finished ones
+    struct Registry {
+        std::mutex                  mutex;
+        std::vector<LocalCounters*> threads;
+        Counters                    retired;
+    };
+
+    Registry& registry() {
+        // Never destroyed, threads may finish after static destructors
+        static auto* instance = new Registry();
+        return *instance;
+    }
+
+    void accumulate(Counters& sum, const LocalCounters& local) {
+        for(size_t i = 0; i < 7; ++i)
+            sum.generated[i] += local.generated[i].load(std::memory_order_relaxed);
+        sum.applied += local.applied.load(std::memory_order_relaxed);
+        for(size_t i = 0; i < lc::MOVE_ERROR_COUNT; ++i)
+            sum.rejected[i] += local.rejected[i].load(std::memory_order_relaxed);
+    }
+
+    void clear(LocalCounters& local) {
+        for(auto& counter : local.generated)
+            counter.store(0, std::memory_order_relaxed);
+        local.applied.store(0, std::memory_order_relaxed);
+        for(auto& counter : local.rejected)
+            counter.store(0, std::memory_order_relaxed);
+    }
+
+    // Registers the counters of a thread for its lifetime
+    struct ThreadCounters {
+        LocalCounters counters;
+
+        ThreadCounters() {
+            auto& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            reg.threads.push_back(&counters);
+        }
+
+        ~ThreadCounters() {
+            auto& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            accumulate(reg.retired, counters);
+            reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), &counters));
+        }
+    };
+
+    std::atomic<lc::trace::Sink> sink = nullptr;
+}
+
+namespace lc::trace {
+    Counters counters() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        Counters sum = reg.retired;
+        for(const auto* local : reg.threads)
+            accumulate(sum, *local);
+        return sum;
+    }
+
+    void reset_counters() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.retired = {};
+        for(auto* local : reg.threads)
+            clear(*local);
+    }
+
+    void set_sink(Sink new_sink) {
+        sink.store(new_sink, std::memory_order_release);
+    }
+
+    namespace detail {
+        LocalCounters& local() {
+            thread_local ThreadCounters thread_counters;
+            return thread_counters.counters;
+        }
+
+        void emit(const Event& event) {
+            if(const auto current = sink.load(std::memory_order_acquire))
+                current(event);
+        }
+    }
+}
+
+#else
+
+namespace lc::trace {
+    Counters counters() { return {}; }
+    void reset_counters() {}
+    void set_sink(Sink) {}
+}
+
+#endif
\ No newline at end of file
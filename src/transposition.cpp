@@ -0,0 +1,189 @@
+#include "transposition.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace {
+    // Data word layout
+    // | move 16 | score 16 | eval 16 | depth 8 | bound 2 | age 6 |
+    uint64_t pack(const lc::TTData& data, uint8_t age) {
+        return uint64_t(data.move.raw())
+            | (uint64_t(uint16_t(data.score)) << 16)
+            | (uint64_t(uint16_t(data.eval)) << 32)
+            | (uint64_t(data.depth) << 48)
+            | (uint64_t(data.bound & 0b11) << 56)
+            | (uint64_t(age & 0x3f) << 58);
+    }
+
+    lc::TTData unpack(uint64_t data) {
+        return {
+            lc::PackedMove::from_raw(uint16_t(data)),
+            int16_t(uint16_t(data >> 16)),
+            int16_t(uint16_t(data >> 32)),
+            uint8_t(data >> 48),
+            uint8_t((data >> 56) & 0b11)
+        };
+    }
+
+    uint8_t age_of(uint64_t data) { return uint8_t(data >> 58); }
+    uint8_t depth_of(uint64_t data) { return uint8_t(data >> 48); }
+
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+}
+
+namespace lc {
+    TranspositionTable::TranspositionTable(size_t size_mb, bool use_huge_pages)
+        : buckets(nullptr)
+        , bucket_mask(0)
+        , mapped(false)
+        , age(0)
+    {
+        allocate(size_mb, use_huge_pages);
+    }
+
+    TranspositionTable::~TranspositionTable() {
+        deallocate();
+    }
+
+    void TranspositionTable::resize(size_t size_mb, bool use_huge_pages) {
+        deallocate();
+        allocate(size_mb, use_huge_pages);
+    }
+
+    void TranspositionTable::allocate(size_t size_mb, bool use_huge_pages) {
+        // Power of two number of buckets, at least one
+        size_t count = 1;
+        while(count * 2 * sizeof(Bucket) <= size_mb * 1024 * 1024)
+            count *= 2;
+        const size_t bytes = count * sizeof(Bucket);
+        bucket_mask = count - 1;
+
+        void* memory = nullptr;
+    #if defined(__linux__)
+        if(use_huge_pages && bytes >= HUGE_PAGE_SIZE) {
+            // Explicit huge pages, needs pages reserved by the system
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(memory == MAP_FAILED) {
+                memory = nullptr;
+            }
+            else {
+                mapped = true;
+            }
+        }
+    #endif
+        if(!memory) {
+            const size_t alignment = use_huge_pages && bytes >= HUGE_PAGE_SIZE
+                ? HUGE_PAGE_SIZE
+                : alignof(Bucket);
+            memory = std::aligned_alloc(alignment, bytes);
+            if(!memory)
+                throw std::bad_alloc();
+        #if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // Transparent huge pages as fallback
+            if(use_huge_pages)
+                madvise(memory, bytes, MADV_HUGEPAGE);
+        #endif
+        }
+
+        buckets = static_cast<Bucket*>(memory);
+        clear();
+    }
+
+    void TranspositionTable::deallocate() {
+        if(!buckets)
+            return;
+    #if defined(__linux__)
+        if(mapped)
+            munmap(buckets, size_bytes());
+        else
+    #endif
+            std::free(buckets);
+        buckets = nullptr;
+        mapped = false;
+    }
+
+    void TranspositionTable::clear() {
+        // Atomics of integers are trivially zero initializable
+        std::memset(static_cast<void*>(buckets), 0, size_bytes());
+        age = 0;
+    }
+
+    bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+        for(const auto& entry : bucket(key).entries) {
+            const auto data = entry.data.load(std::memory_order_relaxed);
+            const auto check = entry.check.load(std::memory_order_relaxed);
+            if((check ^ data) == key) {
+                out = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TranspositionTable::store(uint64_t key, const TTData& data) {
+        auto& b = bucket(key);
+
+        // Same position entry if any, otherwise the entry with the
+        // lowest depth, where each search of age counts as 8 plies
+        Entry* replace = &b.entries[0];
+        int replace_worth = 1 << 30;
+        uint64_t old_data = 0;
+        for(auto& entry : b.entries) {
+            const auto entry_data = entry.data.load(std::memory_order_relaxed);
+            const auto entry_check = entry.check.load(std::memory_order_relaxed);
+            if((entry_check ^ entry_data) == key) {
+                replace = &entry;
+                old_data = entry_data;
+                break;
+            }
+            const int relative_age = (age - age_of(entry_data)) & 0x3f;
+            const int worth = int(depth_of(entry_data)) - 8 * relative_age;
+            if(worth < replace_worth) {
+                replace = &entry;
+                replace_worth = worth;
+            }
+        }
+
+        auto new_data = data;
+        if(old_data) {
+            const auto old = unpack(old_data);
+            // Keep a shallower result of this search with the same
+            // position unless it's exact
+            if(age_of(old_data) == age
+                && data.bound != BOUND_EXACT
+                && data.depth + 2 < old.depth)
+            {
+                return;
+            }
+            // Keep the known best move
+            if(new_data.move.is_none())
+                new_data.move = old.move;
+        }
+
+        const auto packed = pack(new_data, age);
+        replace->data.store(packed, std::memory_order_relaxed);
+        replace->check.store(key ^ packed, std::memory_order_relaxed);
+    }
+
+    void TranspositionTable::prefetch(uint64_t key) const {
+        __builtin_prefetch(&bucket(key));
+    }
+
+    int TranspositionTable::hashfull() const {
+        const size_t samples = bucket_mask + 1 < 250 ? bucket_mask + 1 : 250;
+        int used = 0;
+        for(size_t i = 0; i < samples; ++i) {
+            for(const auto& entry : buckets[i].entries) {
+                const auto data = entry.data.load(std::memory_order_relaxed);
+                used += data != 0 && age_of(data) == age;
+            }
+        }
+        return int(used * 1000 / (samples * ENTRIES_PER_BUCKET));
+    }
+}
@@ -0,0 +1,163 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive.hpp"
+#include "notation.hpp"
+#include "pgn.hpp"
+#include "polyglot.hpp"
+
+// Test positions of the Polyglot book format documentation
+struct KeyEntry {
+    const char* fen;
+    uint64_t    key;
+};
+
+const KeyEntry KEY_SUITE[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9c },
+    { "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196 },
+    { "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0 },
+    { "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4 },
+    { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78 },
+    { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1 },
+    { "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9 },
+    { "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637 },
+    { "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560 }
+};
+
+// Compares the keys of the test positions, returns true if all match
+bool check_keys() {
+    bool ok = true;
+    for(const auto& entry : KEY_SUITE) {
+        const auto game = lc::game_from_fen(entry.fen);
+        const uint64_t key = game.has_value() ? lc::polyglot::key(*game) : 0;
+        const bool pass = key == entry.key;
+        ok &= pass;
+        fmt::print("{}: {:016x} (expected {:016x}) {}\n", entry.fen, key, entry.key, pass ? "OK" : "FAIL");
+    }
+    return ok;
+}
+
+// Adds the games of a PGN file, or of a binary archive otherwise.
+// False if the file can't be read
+bool add_file(lc::polyglot::BookBuilder& builder, const std::string& path, size_t plies, unsigned threads) {
+    if(std::string_view(path).ends_with(".pgn")) {
+        const auto stats = lc::read_pgn_file(path, [&](const lc::PgnGame& pgn) {
+            // Games come at their final position
+            auto start = pgn.game;
+            while(start.undo());
+            builder.add_game(std::move(start), pgn.game.history(), pgn.result, plies);
+        }, threads);
+        if(!stats.has_value())
+            return false;
+        fmt::print("{}: {} games, {} invalid\n", path, stats->games, stats->invalid_games);
+        return true;
+    }
+
+    lc::ArchiveReader archive(path);
+    if(!archive.is_open())
+        return false;
+    size_t invalid = 0;
+    for(const auto game : archive) {
+        auto start = lc::start_game(game);
+        invalid += !start.has_value()
+            || !builder.add_game(std::move(*start), game.moves, game.result, plies);
+    }
+    fmt::print("{}: {} games, {} invalid\n", path, archive.size(), invalid);
+    return true;
+}
+
+// Prints the book moves of a position
+bool probe(const std::string& book_path, const std::string& fen) {
+    const lc::polyglot::Book book(book_path);
+    if(!book.is_open()) {
+        fmt::print("Can't open book: {}\n", book_path);
+        return false;
+    }
+    const auto game = lc::game_from_fen(fen);
+    if(!game.has_value()) {
+        fmt::print("Invalid FEN: {}\n", fen);
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto moves = book.probe(*game);
+    const auto end = std::chrono::steady_clock::now();
+
+    fmt::print("Key: {:016x}\n", lc::polyglot::key(*game));
+    for(const auto& book_move : moves)
+        fmt::print("{}: {}\n", lc::move_name(book_move.move), book_move.weight);
+    fmt::print("{} moves in {} us\n", moves.size(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    return true;
+}
+
+void usage() {
+    fmt::print(
+        "Usage: book [-p plies] [-m min_count] [-t threads] -o book.bin input...\n"
+        "       book -f fen book.bin\n"
+        "       book --check\n"
+        "Inputs are PGN files (.pgn) or binary game archives. '--check'\n"
+        "compares the keys of the Polyglot documentation test positions\n");
+}
+
+int main(int argc, char** argv) {
+    size_t plies = 20;
+    uint16_t min_count = 1;
+    unsigned threads = 0;
+    std::string output;
+    std::string fen;
+    bool check = false;
+    std::vector<std::string> inputs;
+
+    for(int i = 1; i < argc; ++i) {
+        if(!std::strcmp(argv[i], "-p") && i + 1 < argc) {
+            plies = size_t(std::max(1, std::atoi(argv[++i])));
+        }
+        else if(!std::strcmp(argv[i], "-m") && i + 1 < argc) {
+            min_count = uint16_t(std::clamp(std::atoi(argv[++i]), 1, int(UINT16_MAX)));
+        }
+        else if(!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = unsigned(std::max(0, std::atoi(argv[++i])));
+        }
+        else if(!std::strcmp(argv[i], "--check")) {
+            check = true;
+        }
+        else if(!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if(check)
+        return check_keys() ? 0 : 1;
+    if(!fen.empty() && inputs.size() == 1)
+        return probe(inputs[0], fen) ? 0 : 1;
+    if(output.empty() || inputs.empty()) {
+        usage();
+        return 1;
+    }
+
+    lc::polyglot::BookBuilder builder;
+    for(const auto& input : inputs) {
+        if(!add_file(builder, input, plies, threads)) {
+            fmt::print("Can't read: {}\n", input);
+            return 1;
+        }
+    }
+    if(!builder.write(output, min_count)) {
+        fmt::print("Can't write: {}\n", output);
+        return 1;
+    }
+    fmt::print("Wrote {} entries to {}\n", builder.size(), output);
+}
@@ -0,0 +1,246 @@
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "game.hpp"
+#include "notation.hpp"
+
+// Leaf nodes count of the game tree up to 'depth'
+uint64_t perft(lc::ChessGame& game, int depth) {
+    lc::MoveList moves;
+    game.legal_moves(moves);
+    // Bulk counting, leaf moves don't need to be applied
+    if(depth <= 1)
+        return depth == 1 ? moves.size() : 1;
+
+    uint64_t nodes = 0;
+    for(const auto& move : moves) {
+        game.make_move(move);
+        nodes += perft(game, depth - 1);
+        game.undo();
+    }
+    return nodes;
+}
+
+struct DivideResult {
+    lc::Move move;
+    uint64_t nodes;
+};
+
+// Splits root moves across 'threads' workers, each one with its own
+// copy of the game
+std::vector<DivideResult> divide(const lc::ChessGame& game, int depth, unsigned threads) {
+    const auto root_moves = game.legal_moves();
+    std::vector<DivideResult> results;
+    for(const auto& move : root_moves)
+        results.push_back({move, 0});
+
+    std::atomic<size_t> next_move = 0;
+    auto worker = [&]() {
+        for(size_t i = next_move++; i < results.size(); i = next_move++) {
+            auto child = game;
+            child.make_move(results[i].move);
+            results[i].nodes = perft(child, depth - 1);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for(auto& thread : pool)
+        thread.join();
+    return results;
+}
+
+// Runs divide, prints it and returns the total nodes count
+uint64_t run(const lc::ChessGame& game, int depth, unsigned threads, bool print_divide) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto results = divide(game, depth, threads);
+    const auto end = std::chrono::steady_clock::now();
+
+    uint64_t nodes = 0;
+    for(const auto& result : results) {
+        if(print_divide)
+            fmt::print("{}: {}\n", lc::move_name(result.move), result.nodes);
+        nodes += result.nodes;
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    const auto nps = ms > 0 ? nodes * 1000 / ms : 0;
+    fmt::print("\nNodes: {}\nTime: {} ms\nNPS: {}\n", nodes, ms, nps);
+    return nodes;
+}
+
+struct SuiteEntry {
+    const char* fen;
+    std::vector<uint64_t> nodes; // Indexed by depth - 1
+};
+
+// Standard perft positions (chessprogramming.org/Perft_Results)
+const SuiteEntry SUITE[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        { 20, 400, 8902, 197281, 4865609 } },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        { 48, 2039, 97862, 4085603 } },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        { 14, 191, 2812, 43238, 674624 } },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        { 6, 264, 9467, 422333 } },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        { 44, 1486, 62379, 2103487 } },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        { 46, 2079, 89890, 3894594 } },
+};
+
+struct StatusEntry {
+    const char* fen;
+    // Played with 'ChessGame::move', "0000" is a null move
+    const char* moves;
+    // Played last and expected to be rejected, nullptr if none
+    const char* rejected;
+    lc::GameStatus status;
+    int repetitions;
+};
+
+const StatusEntry STATUS_SUITE[] = {
+    // Fool's mate
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "f2f3 e7e5 g2g4 d8h4", nullptr, lc::GameStatus::Checkmate, 0 },
+    { "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",
+        "", nullptr, lc::GameStatus::Stalemate, 0 },
+    // Mate on the last ply before the fifty move rule still counts
+    { "7k/8/6K1/8/8/8/8/5Q2 w - - 99 80",
+        "f1f8", nullptr, lc::GameStatus::Checkmate, 0 },
+    { "4k3/8/8/8/8/8/8/R3K3 w - - 99 80",
+        "a1a2", nullptr, lc::GameStatus::FiftyMoveRule, 0 },
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "g1f3 g8f6 f3g1 f6g8", nullptr, lc::GameStatus::Ongoing, 1 },
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8", nullptr, lc::GameStatus::ThreefoldRepetition, 2 },
+    // Positions before a null move can't repeat
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "g1f3 g8f6 f3g1 f6g8 0000 0000", nullptr, lc::GameStatus::Ongoing, 0 },
+    { "8/8/4k3/8/8/3K4/8/5B2 w - - 0 1",
+        "", nullptr, lc::GameStatus::InsufficientMaterial, 0 },
+    // Moves leaving the own king in check are rejected
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "e2e4 f7f6 d1h5", "a7a6", lc::GameStatus::Ongoing, 0 },
+    // Castling rights without the rook are dropped by the FEN parser
+    { "4k3/8/8/8/8/8/8/4K3 w K - 0 1",
+        "", "e1g1", lc::GameStatus::InsufficientMaterial, 0 },
+};
+
+// Plays a move given as from and to squares ("e2e4"), false if it
+// can't be parsed or is rejected
+bool play(lc::ChessGame& game, std::string_view move) {
+    if(move == "0000") {
+        game.make_null_move();
+        return true;
+    }
+    const auto from = lc::parse_square(move.substr(0, 2));
+    const auto to = lc::parse_square(move.substr(2));
+    return from.has_value() && to.has_value()
+        && game.move(lc::position_of(*from), lc::position_of(*to)) == lc::MoveError::None;
+}
+
+// Compares the status and repetitions of known positions, returns
+// true if all match
+bool run_status_suite() {
+    bool ok = true;
+    for(const auto& entry : STATUS_SUITE) {
+        auto game = lc::game_from_fen(entry.fen);
+        bool pass = game.has_value();
+        std::string_view moves = entry.moves;
+        while(pass && !moves.empty()) {
+            const auto end = std::min(moves.find(' '), moves.size());
+            pass = play(*game, moves.substr(0, end));
+            moves.remove_prefix(std::min(end + 1, moves.size()));
+        }
+        if(pass && entry.rejected)
+            pass = !play(*game, entry.rejected);
+        pass = pass
+            && game->status() == entry.status
+            && game->repetitions() == entry.repetitions;
+        ok &= pass;
+        fmt::print("{} {}{}{}: {}\n", entry.fen, entry.moves,
+            entry.rejected ? ", rejects " : "", entry.rejected ? entry.rejected : "", pass ? "OK" : "FAIL");
+    }
+    return ok;
+}
+
+// Checks every suite position up to 'max_depth', returns true if all match
+bool run_suite(int max_depth, unsigned threads) {
+    bool ok = true;
+    for(const auto& entry : SUITE) {
+        const auto game = lc::game_from_fen(entry.fen);
+        for(int depth = 1; depth <= max_depth && depth <= int(entry.nodes.size()); ++depth) {
+            const auto results = divide(*game, depth, threads);
+            uint64_t nodes = 0;
+            for(const auto& result : results)
+                nodes += result.nodes;
+
+            const bool pass = nodes == entry.nodes[depth - 1];
+            ok &= pass;
+            fmt::print("{} depth {}: {} (expected {}) {}\n",
+                entry.fen, depth, nodes, entry.nodes[depth - 1], pass ? "OK" : "FAIL");
+        }
+    }
+    return ok;
+}
+
+void usage() {
+    fmt::print(
+        "Usage: perft [-t threads] [-f fen] [-q] depth\n"
+        "       perft [-t threads] --suite [max_depth]\n"
+        "       perft --status\n");
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string fen(lc::STARTING_FEN);
+    bool suite = false;
+    bool print_divide = true;
+    int depth = -1;
+
+    for(int i = 1; i < argc; ++i) {
+        if(!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "-q")) {
+            print_divide = false;
+        }
+        else if(!std::strcmp(argv[i], "--suite")) {
+            suite = true;
+        }
+        else if(!std::strcmp(argv[i], "--status")) {
+            return run_status_suite() ? 0 : 1;
+        }
+        else {
+            depth = std::atoi(argv[i]);
+        }
+    }
+
+    if(suite)
+        return run_suite(depth > 0 ? depth : 4, threads) ? 0 : 1;
+
+    if(depth < 1) {
+        usage();
+        return 1;
+    }
+    const auto game = lc::game_from_fen(fen);
+    if(!game.has_value()) {
+        fmt::print("Invalid FEN: {}\n", fen);
+        return 1;
+    }
+    run(*game, depth, threads, print_divide);
+}
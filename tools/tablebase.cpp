@@ -0,0 +1,129 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "notation.hpp"
+#include "tablebase.hpp"
+
+namespace {
+    std::string result_name(const lc::tablebase::ProbeResult& result) {
+        switch(result.wdl) {
+            case lc::tablebase::Wdl::Win:  return fmt::format("win, mate in {} plies", result.dtm);
+            case lc::tablebase::Wdl::Loss: return fmt::format("loss, mated in {} plies", result.dtm);
+            case lc::tablebase::Wdl::Draw: break;
+        }
+        return "draw";
+    }
+}
+
+// Prints the outcome of a position and of each of its moves
+bool probe(const std::string& directory, const std::string& fen) {
+    lc::tablebase::Tablebases tables;
+    tables.open(directory);
+    auto game = lc::game_from_fen(fen);
+    if(!game.has_value()) {
+        fmt::print("Invalid FEN: {}\n", fen);
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = tables.probe(*game);
+    const auto end = std::chrono::steady_clock::now();
+    if(!result.has_value()) {
+        fmt::print("Not in the tables, or castling still possible: {}\n",
+            lc::tablebase::material_name(game->board));
+        return false;
+    }
+    fmt::print("{}: {} ({} ns)\n", lc::tablebase::material_name(game->board), result_name(*result),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+    for(const auto& move : game->legal_moves()) {
+        game->make_move(move);
+        const auto child = tables.probe(*game);
+        game->undo();
+        if(child.has_value())
+            fmt::print("  {}: {}\n", lc::move_name(move), result_name(*child));
+    }
+    return true;
+}
+
+void usage() {
+    fmt::print(
+        "Usage: tablebase [-t threads] [-p pieces] -o directory [set...]\n"
+        "       tablebase -d directory -f fen\n"
+        "Sets are named like KQvKR, all of up to 'pieces' pieces (default {})\n"
+        "by default. Tables already in the directory are kept and used for\n"
+        "the captures and promotions of the others\n",
+        lc::tablebase::MAX_PIECES);
+}
+
+int main(int argc, char** argv) {
+    size_t pieces = lc::tablebase::MAX_PIECES;
+    unsigned threads = 0;
+    std::string output;
+    std::string directory;
+    std::string fen;
+    std::vector<std::string> names;
+
+    for(int i = 1; i < argc; ++i) {
+        if(!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            threads = unsigned(std::max(0, std::atoi(argv[++i])));
+        }
+        else if(!std::strcmp(argv[i], "-p") && i + 1 < argc) {
+            pieces = size_t(std::max(3, std::atoi(argv[++i])));
+        }
+        else if(!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "-d") && i + 1 < argc) {
+            directory = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        else {
+            names.push_back(argv[i]);
+        }
+    }
+
+    if(!fen.empty() && !directory.empty())
+        return probe(directory, fen) ? 0 : 1;
+    if(output.empty()) {
+        usage();
+        return 1;
+    }
+
+    lc::tablebase::Tablebases tables;
+    tables.open(output);
+    // Only missing tables unless some are asked for
+    const bool all = names.empty();
+    if(all)
+        names = lc::tablebase::table_names(pieces);
+
+    lc::ThreadPool pool(threads);
+    for(const auto& name : names) {
+        const auto path = output + "/" + name + ".lctb";
+        if(all && std::ifstream(path))
+            continue;
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto stats = lc::tablebase::generate(name, tables, pool, path);
+        const auto end = std::chrono::steady_clock::now();
+        if(!stats.has_value()) {
+            fmt::print("Can't generate {}: unknown set, missing tables or unwritable file\n", name);
+            return 1;
+        }
+        if(!tables.add(path)) {
+            fmt::print("Can't read back: {}\n", path);
+            return 1;
+        }
+        fmt::print("{}: {} positions, {} wins, {} draws, {} losses, longest mate {} plies ({} ms)\n",
+            name, stats->positions, stats->wins, stats->draws, stats->losses, stats->longest_mate,
+            std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    }
+}
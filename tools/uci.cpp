@@ -0,0 +1,338 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "game.hpp"
+#include "notation.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+#include "transposition.hpp"
+
+// Universal Chess Interface front end. Input is read on the main
+// thread while the search runs on its own, 'stop' and 'ponderhit'
+// only set flags the search polls every node
+
+namespace {
+    // Kept off the clock for GUI and pipe latency, milliseconds
+    constexpr int64_t MOVE_OVERHEAD = 30;
+    // Moves the remaining time is split over without 'movestogo'
+    constexpr int64_t DEFAULT_MOVES_TO_GO = 30;
+
+    std::mutex output_mutex;
+
+    // Lines are written whole and flushed, from either thread
+    template<typename... Args>
+    void send(fmt::format_string<Args...> format, Args&&... args) {
+        std::lock_guard lock(output_mutex);
+        fmt::print(format, std::forward<Args>(args)...);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    struct GoParams {
+        lc::SearchLimits limits;
+        int64_t          time[2] = { 0, 0 };
+        int64_t          increment[2] = { 0, 0 };
+        int64_t          moves_to_go = 0;
+        bool             infinite = false;
+        bool             ponder = false;
+    };
+
+    // Milliseconds to think, 0 for no time limit
+    int64_t time_budget(const GoParams& params, lc::Color us) {
+        if(params.limits.movetime)
+            return params.limits.movetime;
+        const int side = us == WHITE ? 0 : 1;
+        const auto time = params.time[side];
+        if(time <= 0)
+            return 0;
+        const auto moves_to_go = params.moves_to_go > 0 ? params.moves_to_go : DEFAULT_MOVES_TO_GO;
+        const auto budget = time / moves_to_go + params.increment[side] * 3 / 4;
+        return std::clamp<int64_t>(budget, 1, std::max<int64_t>(1, time - MOVE_OVERHEAD));
+    }
+
+    std::string score_name(int score) {
+        if(std::abs(score) < lc::SCORE_MATE_IN_MAX_PLY)
+            return fmt::format("cp {}", score);
+        // Plies to mate, as moves
+        const int plies = lc::SCORE_MATE - std::abs(score);
+        return fmt::format("mate {}", score > 0 ? (plies + 1) / 2 : -(plies / 2));
+    }
+
+    class UciEngine {
+        private:
+        lc::ChessGame          game;
+        lc::TranspositionTable tt;
+        unsigned               threads;
+        lc::tablebase::Tablebases tablebases;
+
+        std::thread            search_thread;
+        // Timer started by 'ponderhit', stops a ponder search once
+        // its time budget runs out
+        std::thread            timer_thread;
+        std::atomic<bool>      stop;
+        // Guarded by 'mutex', the search thread holds 'bestmove'
+        // until neither is set
+        std::mutex             mutex;
+        std::condition_variable cv;
+        bool                   pondering;
+        bool                   infinite;
+        bool                   searching;
+        // Time budget of the ponder search, applied on 'ponderhit'
+        int64_t                ponder_budget;
+
+        public:
+        UciEngine()
+            : game(lc::Board::standard())
+            , tt(16)
+            , threads(1)
+            , stop(false)
+            , pondering(false)
+            , infinite(false)
+            , searching(false)
+            , ponder_budget(0) {}
+
+        ~UciEngine() { wait_search(); }
+
+        // Returns false on 'quit'
+        bool command(const std::string& line);
+
+        private:
+        void uci();
+        void set_option(std::istringstream& input);
+        void position(std::istringstream& input);
+        void go(std::istringstream& input);
+        void ponder_hit();
+        // Returns right away, 'bestmove' is sent by the search thread
+        void request_stop();
+        // Stops and joins the search, before the game or options change
+        void wait_search();
+        void run_search(lc::ChessGame root, GoParams params);
+    };
+
+    bool UciEngine::command(const std::string& line) {
+        std::istringstream input(line);
+        std::string token;
+        input >> token;
+
+        if(token == "uci")
+            uci();
+        else if(token == "isready")
+            send("readyok");
+        else if(token == "setoption")
+            set_option(input);
+        else if(token == "ucinewgame") {
+            wait_search();
+            tt.clear();
+        }
+        else if(token == "position")
+            position(input);
+        else if(token == "go")
+            go(input);
+        else if(token == "stop")
+            request_stop();
+        else if(token == "ponderhit")
+            ponder_hit();
+        else if(token == "quit")
+            return false;
+        // Unknown commands are ignored, as the protocol requires
+        return true;
+    }
+
+    void UciEngine::uci() {
+        send("id name light_chess");
+        send("id author K1llByte");
+        send("option name Hash type spin default 16 min 1 max 65536");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name Ponder type check default false");
+        send("option name TablebasePath type string default <empty>");
+        send("uciok");
+    }
+
+    void UciEngine::set_option(std::istringstream& input) {
+        // "name <id> [value <x>]", names may have spaces
+        std::string token;
+        std::string name;
+        std::string value;
+        input >> token;
+        while(input >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        std::getline(input >> std::ws, value);
+
+        wait_search();
+        if(name == "Hash")
+            tt.resize(size_t(std::clamp(std::atoi(value.c_str()), 1, 65536)));
+        else if(name == "Threads")
+            threads = unsigned(std::clamp(std::atoi(value.c_str()), 1, 256));
+        else if(name == "TablebasePath") {
+            tablebases.close();
+            if(!value.empty() && value != "<empty>")
+                send("info string {} tablebases loaded", tablebases.open(value));
+        }
+        // 'Ponder' only tells whether the GUI will ponder
+        else if(name != "Ponder")
+            send("info string unknown option {}", name);
+    }
+
+    void UciEngine::position(std::istringstream& input) {
+        wait_search();
+        std::string token;
+        input >> token;
+
+        std::optional<lc::ChessGame> next;
+        if(token == "startpos") {
+            next.emplace(lc::Board::standard());
+            input >> token;
+        }
+        else if(token == "fen") {
+            std::string fen;
+            while(input >> token && token != "moves")
+                fen += token + ' ';
+            next = lc::game_from_fen(fen);
+            if(!next.has_value()) {
+                send("info string invalid fen {}", fen);
+                return;
+            }
+        }
+        else {
+            return;
+        }
+
+        if(token == "moves") {
+            while(input >> token) {
+                const auto move = lc::parse_move(*next, token);
+                if(!move.has_value()) {
+                    send("info string illegal move {}", token);
+                    return;
+                }
+                next->make_move(*move);
+            }
+        }
+        game = std::move(*next);
+    }
+
+    void UciEngine::go(std::istringstream& input) {
+        wait_search();
+        GoParams params;
+        params.limits.threads = threads;
+        if(tablebases.size() > 0)
+            params.limits.tablebases = &tablebases;
+        std::string token;
+        while(input >> token) {
+            const auto read = [&]() {
+                int64_t value = 0;
+                input >> value;
+                return value;
+            };
+            if(token == "depth")
+                params.limits.depth = int(std::clamp<int64_t>(read(), 1, lc::MAX_PLY - 1));
+            else if(token == "nodes")
+                params.limits.nodes = uint64_t(std::max<int64_t>(read(), 1));
+            else if(token == "movetime")
+                params.limits.movetime = std::max<int64_t>(read(), 1);
+            else if(token == "wtime")
+                params.time[0] = read();
+            else if(token == "btime")
+                params.time[1] = read();
+            else if(token == "winc")
+                params.increment[0] = read();
+            else if(token == "binc")
+                params.increment[1] = read();
+            else if(token == "movestogo")
+                params.moves_to_go = read();
+            else if(token == "infinite")
+                params.infinite = true;
+            else if(token == "ponder")
+                params.ponder = true;
+        }
+
+        const auto budget = time_budget(params, game.turn());
+        // Pondering runs without a clock until 'ponderhit'
+        params.limits.movetime = params.ponder || params.infinite ? 0 : budget;
+
+        stop = false;
+        pondering = params.ponder;
+        infinite = params.infinite;
+        searching = true;
+        ponder_budget = budget;
+        search_thread = std::thread(&UciEngine::run_search, this, game, params);
+    }
+
+    void UciEngine::ponder_hit() {
+        std::lock_guard lock(mutex);
+        if(!searching || !pondering)
+            return;
+        pondering = false;
+        cv.notify_all();
+        if(ponder_budget == 0 || infinite)
+            return;
+        // Clock starts now, the search is stopped once the budget
+        // runs out unless it ends first
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ponder_budget);
+        timer_thread = std::thread([this, deadline]() {
+            std::unique_lock timer_lock(mutex);
+            if(!cv.wait_until(timer_lock, deadline, [this]() { return !searching || stop; }))
+                stop = true;
+        });
+    }
+
+    void UciEngine::request_stop() {
+        std::lock_guard lock(mutex);
+        stop = true;
+        cv.notify_all();
+    }
+
+    void UciEngine::wait_search() {
+        request_stop();
+        if(search_thread.joinable())
+            search_thread.join();
+        if(timer_thread.joinable())
+            timer_thread.join();
+    }
+
+    void UciEngine::run_search(lc::ChessGame root, GoParams params) {
+        const auto result = lc::search(root, tt, params.limits, stop, [&](const lc::SearchResult& iteration) {
+            std::string pv;
+            for(const auto& move : iteration.pv)
+                pv += ' ' + lc::move_name(move);
+            const auto nps = iteration.time > 0 ? iteration.nodes * 1000 / uint64_t(iteration.time) : 0;
+            send("info depth {} score {} nodes {} nps {} time {} hashfull {} pv{}",
+                iteration.depth, score_name(iteration.score), iteration.nodes,
+                nps, iteration.time, tt.hashfull(), pv);
+        });
+
+        // 'bestmove' can't be sent before 'stop' or 'ponderhit' when
+        // pondering or searching infinitely, even if the search ended
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this]() { return (!pondering && !infinite) || stop; });
+
+        if(!result.best_move.has_value())
+            send("bestmove 0000");
+        else if(result.pv.size() >= 2)
+            send("bestmove {} ponder {}", lc::move_name(*result.best_move), lc::move_name(result.pv[1]));
+        else
+            send("bestmove {}", lc::move_name(*result.best_move));
+        searching = false;
+        cv.notify_all();
+    }
+}
+
+int main() {
+    // Input and output are line based, the GUI waits on each answer
+    std::ios::sync_with_stdio(false);
+    UciEngine engine;
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        if(!engine.command(line))
+            break;
+    }
+}
\ No newline at end of file
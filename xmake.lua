@@ -17,4 +17,52 @@ target("light_chess")
     add_packages("fmt")
     -- Binary
     set_kind("binary")
-    add_files("src/**.cpp")
\ No newline at end of file
+    add_files("src/**.cpp")
+
+-- Target Perft (move generation benchmark)
+target("perft")
+    set_languages("cxx20")
+    set_warnings("allextra")
+    set_optimize("fastest")
+    set_targetdir("bin/")
+    add_includedirs("include")
+    add_packages("fmt")
+    add_syslinks("pthread")
+    set_kind("binary")
+    add_files("src/**.cpp|main.cpp", "tools/perft.cpp")
+
+-- Target UCI (engine protocol front end)
+target("uci")
+    set_languages("cxx20")
+    set_warnings("allextra")
+    set_optimize("fastest")
+    set_targetdir("bin/")
+    add_includedirs("include")
+    add_packages("fmt")
+    add_syslinks("pthread")
+    set_kind("binary")
+    add_files("src/**.cpp|main.cpp", "tools/uci.cpp")
+
+-- Target Book (Polyglot opening book builder)
+target("book")
+    set_languages("cxx20")
+    set_warnings("allextra")
+    set_optimize("fastest")
+    set_targetdir("bin/")
+    add_includedirs("include")
+    add_packages("fmt")
+    add_syslinks("pthread")
+    set_kind("binary")
+    add_files("src/**.cpp|main.cpp", "tools/book.cpp")
+
+-- Target Tablebase (endgame tablebase generator)
+target("tablebase")
+    set_languages("cxx20")
+    set_warnings("allextra")
+    set_optimize("fastest")
+    set_targetdir("bin/")
+    add_includedirs("include")
+    add_packages("fmt")
+    add_syslinks("pthread")
+    set_kind("binary")
+    add_files("src/**.cpp|main.cpp", "tools/tablebase.cpp")